@@ -50,29 +50,98 @@ typedef struct _header_ {
 # endif
 
 
+typedef struct _mblock_ {
+    struct _mblock_ *next;	/* next in list */
+    size_t size;		/* size of block */
+    bool huge;			/* backed by huge pages? */
+} mblock;
+
+# define MBLOCKSZ	ALGN(sizeof(mblock), STRUCT_AL)
+
 static allocinfo mstat;		/* memory statistics */
+static int mflags;		/* page allocation flags */
+static size_t mretain;		/* free memory to retain after a purge */
+static mblock *rlist;		/* retained free memory blocks */
 
 /*
  * NAME:	newmem()
  * DESCRIPTION:	allocate new memory
  */
-static char *newmem(size_t size, char **list)
+static char *newmem(size_t size, mblock **list)
 {
     char *mem;
+    mblock *b, **r;
+    bool huge;
 
-    if (list != (char **) NULL) {
-	size += ALGN(sizeof(char *), STRUCT_AL);
+    if (list == (mblock **) NULL) {
+	mem = (char *) malloc(size);
+	if (mem == (char *) NULL) {
+	    fatal("out of memory");
+	}
+	return mem;
     }
-    mem = (char *) malloc(size);
-    if (mem == (char *) NULL) {
+
+    size += MBLOCKSZ;
+    for (r = &rlist; *r != (mblock *) NULL; r = &(*r)->next) {
+	if ((*r)->size >= size) {
+	    /* reuse retained block */
+	    b = *r;
+	    *r = b->next;
+	    mstat.retained -= b->size;
+	    b->next = *list;
+	    *list = b;
+	    return (char *) b + MBLOCKSZ;
+	}
+    }
+
+    /*
+     * allocate pages from the system, backed by huge pages if possible
+     */
+    if ((mflags & PA_HUGE) && size >= HUGEPAGESZ / 2) {
+	size = ALGN(size, HUGEPAGESZ);
+	b = (mblock *) P_palloc(size, mflags, &huge);
+    } else {
+	b = (mblock *) P_palloc(size, mflags & ~PA_HUGE, &huge);
+    }
+    if (b == (mblock *) NULL) {
 	fatal("out of memory");
     }
-    if (list != (char **) NULL) {
-	*((char **) mem) = *list;
-	*list = mem;
-	mem += ALGN(sizeof(char *), STRUCT_AL);
+    b->size = size;
+    b->huge = huge;
+    if (huge) {
+	mstat.hugesize += size;
+    }
+    b->next = *list;
+    *list = b;
+    return (char *) b + MBLOCKSZ;
+}
+
+/*
+ * NAME:	delmem()
+ * DESCRIPTION:	release a list of memory blocks, retaining up to the
+ *		given amount for reuse
+ */
+static void delmem(mblock **list, size_t keep)
+{
+    mblock *b;
+
+    while (*list != (mblock *) NULL) {
+	b = *list;
+	*list = b->next;
+	if (mstat.retained + b->size <= keep) {
+	    /* keep for reuse */
+	    b->next = rlist;
+	    rlist = b;
+	    mstat.retained += b->size;
+	} else {
+	    /* return to the system */
+	    if (b->huge) {
+		mstat.hugesize -= b->size;
+	    }
+	    mstat.released += b->size;
+	    P_pfree((char *) b, b->size);
+	}
     }
-    return mem;
 }
 
 /*
@@ -90,7 +159,7 @@ typedef struct {
     chunk *list;		/* list of chunks (possibly empty) */
 } clist;
 
-static char *slist;			/* list of static chunks */
+static mblock *slist;			/* list of static chunks */
 static chunk *schunk;			/* current chunk */
 static size_t schunksz;			/* size of current chunk */
 static chunk *schunks[SCHUNKS];		/* lists of small free chunks */
@@ -516,14 +585,178 @@ static void delete(chunk *c)
     }
 }
 
-# define DSMALL		64
+# define DSMALL		256
 # define DLIMIT		(DSMALL + MOFFSET)
 # define DCHUNKS	(DSMALL / STRUCT_AL - 1)
-# define DCHUNKSZ	32768
+# define SLABSZ		16384		/* slab size, power of two */
+# define SLABOFFSET	ALGN(sizeof(slab), STRUCT_AL)
+# define SLABMAX	(SLABSZ / (MOFFSET + STRUCT_AL))
+# define SLAB(c)	((slab *) ((uintptr_t) (c) & ~(uintptr_t) (SLABSZ - 1)))
+
+typedef struct _slab_ {
+    struct _slab_ *prev;	/* previous slab with free chunks */
+    struct _slab_ *next;	/* next slab with free chunks */
+    chunk *flist;		/* free chunks in this slab */
+    unsigned short size;	/* size of chunks in this slab */
+    unsigned short nchunks;	/* # chunks in this slab */
+    unsigned short nused;	/* # chunks in use */
+    unsigned short nfresh;	/* # chunks handed out at least once */
+    Uint map[BMAP(SLABMAX)];	/* chunks in use */
+} slab;
+
+typedef struct {
+    slab *list;			/* slabs with free chunks */
+    Uint nslabs;		/* # slabs */
+    Uint nused;			/* # chunks in use */
+} sclass;
+
+static mblock *dlist;		/* list of dynamic memory chunks */
+static sclass dclasses[DCHUNKS];/* size classes of small chunks */
+static slab *eslabs;		/* empty slabs */
+static char *slabmem;		/* slab memory not yet used */
+static char *slabend;		/* end of slab memory */
+static slabinfo dslabs[DCHUNKS];/* slab statistics */
+
+/*
+ * NAME:	newslab()
+ * DESCRIPTION:	get a slab for chunks of the given size
+ */
+static slab *newslab(size_t size)
+{
+    slab *s;
+    size_t sz;
+
+    if (eslabs != (slab *) NULL) {
+	/* reuse empty slab */
+	s = eslabs;
+	eslabs = s->next;
+    } else {
+	if (slabmem >= slabend) {
+	    /*
+	     * get new slab memory, aligned to the slab size
+	     */
+	    if (mflags & PA_HUGE) {
+		sz = dchunksz;	/* whole huge pages, much larger than a slab */
+	    } else {
+		sz = ALGN(dchunksz, SLABSZ) + SLABSZ;
+	    }
+	    slabmem = newmem(sz, &dlist);
+	    mstat.dmemsize += sz;
+	    slabend = slabmem + sz;
+	    slabmem = (char *) SLAB(slabmem + SLABSZ - 1);
+	    slabend = (char *) SLAB(slabend);
+	}
+	s = (slab *) slabmem;
+	slabmem += SLABSZ;
+	mstat.slabsize += SLABSZ;
+    }
+
+    s->prev = (slab *) NULL;
+    s->next = (slab *) NULL;
+    s->flist = (chunk *) NULL;
+    s->size = size;
+    s->nchunks = (SLABSZ - SLABOFFSET) / size;
+    s->nused = 0;
+    s->nfresh = 0;
+    memset(s->map, '\0', sizeof(s->map));
+    return s;
+}
+
+/*
+ * NAME:	slalloc()
+ * DESCRIPTION:	allocate a small chunk from a slab
+ */
+static chunk *slalloc(size_t size)
+{
+    sclass *sc;
+    slab *s;
+    chunk *c;
+    unsigned int i;
+
+    sc = &dclasses[(size - MOFFSET) / STRUCT_AL - 1];
+    s = sc->list;
+    if (s == (slab *) NULL) {
+	/* no slab with free chunks left in this size class */
+	sc->list = s = newslab(size);
+	sc->nslabs++;
+    }
+
+    if (s->flist != (chunk *) NULL) {
+	/* previously freed chunk */
+	c = s->flist;
+	s->flist = c->next;
+	i = ((char *) c - ((char *) s + SLABOFFSET)) / size;
+    } else {
+	/* chunk never used before */
+	i = s->nfresh++;
+	c = (chunk *) ((char *) s + SLABOFFSET + i * size);
+    }
+    BSET(s->map, i);
+    if (++s->nused == s->nchunks) {
+	/* slab is full */
+	if ((sc->list=s->next) != (slab *) NULL) {
+	    sc->list->prev = (slab *) NULL;
+	}
+	s->next = (slab *) NULL;
+    }
+    sc->nused++;
+    mstat.slabused += size;
+
+    c->size = size;
+    return c;
+}
 
-static char *dlist;		/* list of dynamic memory chunks */
-static chunk *dchunks[DCHUNKS];	/* list of free small chunks */
-static chunk *dchunk;		/* chunk of small chunks */
+/*
+ * NAME:	slfree()
+ * DESCRIPTION:	return a small chunk to its slab
+ */
+static void slfree(chunk *c)
+{
+    sclass *sc;
+    slab *s;
+    unsigned int i;
+
+    s = SLAB(c);
+    i = ((char *) c - ((char *) s + SLABOFFSET)) / s->size;
+# ifdef DEBUG
+    if (s->size != c->size || !BTST(s->map, i)) {
+	fatal("bad small chunk in slfree");
+    }
+# endif
+    BCLR(s->map, i);
+    c->next = s->flist;
+    s->flist = c;
+    sc = &dclasses[(c->size - MOFFSET) / STRUCT_AL - 1];
+    sc->nused--;
+    mstat.slabused -= c->size;
+
+    if (s->nused-- == s->nchunks) {
+	/* slab was full, make it available again */
+	s->prev = (slab *) NULL;
+	if ((s->next=sc->list) != (slab *) NULL) {
+	    s->next->prev = s;
+	}
+	sc->list = s;
+    } else if (s->nused == 0 && (s->prev != (slab *) NULL ||
+				 s->next != (slab *) NULL)) {
+	/*
+	 * slab is empty and not the only one with free chunks: make it
+	 * available for other size classes
+	 */
+	if (s->prev != (slab *) NULL) {
+	    s->prev->next = s->next;
+	} else {
+	    sc->list = s->next;
+	}
+	if (s->next != (slab *) NULL) {
+	    s->next->prev = s->prev;
+	}
+	s->next = eslabs;
+	eslabs = s;
+	sc->nslabs--;
+	mstat.slabsize -= SLABSZ;
+    }
+}
 
 /*
  * NAME:	dalloc()
@@ -539,41 +772,15 @@ static chunk *dalloc(size_t size)
 	/*
 	 * memory manager hasn't been initialized yet
 	 */
-	c = (chunk *) newmem(size, (char **) NULL);
+	c = (chunk *) newmem(size, (mblock **) NULL);
 	c->size = size;
 	return c;
     }
     dmem = TRUE;
 
     if (size < DLIMIT) {
-	/*
-	 * small chunk
-	 */
-	if ((c=dchunks[(size - MOFFSET) / STRUCT_AL - 1]) != (chunk *) NULL) {
-	    /* small chunk from free list */
-	    dchunks[(size - MOFFSET) / STRUCT_AL - 1] = c->next;
-	    return c;
-	}
-	if (dchunk == (chunk *) NULL) {
-	    /* get new chunks chunk */
-	    dchunk = dalloc(DCHUNKSZ);	/* cannot use alloc() here */
-	    p = (char *) dchunk + UINTSIZE;
-	    ((chunk *) p)->size = dchunk->size - UINTSIZE - SIZETSIZE;
-	    dchunk->size |= DM_MAGIC;
-	    dchunk = (chunk *) p;
-	}
-	sz = dchunk->size - size;
-	c = dchunk;
-	c->size = size;
-	if (sz >= DLIMIT - STRUCT_AL) {
-	    /* enough is left for another small chunk */
-	    dchunk = (chunk *) ((char *) c + size);
-	    dchunk->size = sz;
-	} else {
-	    /* waste sz bytes of memory */
-	    dchunk = (chunk *) NULL;
-	}
-	return c;
+	/* small chunk */
+	return slalloc(size);
     }
 
     size += SIZETSIZE;
@@ -640,8 +847,7 @@ static void dfree(chunk *c)
 
     if (c->size < DLIMIT) {
 	/* small chunk */
-	c->next = dchunks[(c->size - MOFFSET) / STRUCT_AL - 1];
-	dchunks[(c->size - MOFFSET) / STRUCT_AL - 1] = c;
+	slfree(c);
 	return;
     }
 
@@ -687,10 +893,22 @@ static void dfree(chunk *c)
  * NAME:	mem->init()
  * DESCRIPTION:	initialize memory manager
  */
-void m_init(size_t ssz, size_t dsz)
+void m_init(size_t ssz, size_t dsz, bool huge, size_t retain)
 {
-    schunksz = ALGN(ssz, STRUCT_AL);
-    dchunksz = ALGN(dsz, STRUCT_AL);
+    mretain = retain;
+    if (huge) {
+	/*
+	 * chunks including their block header fill whole huge pages, and
+	 * are faulted in when allocated
+	 */
+	mflags = PA_HUGE | PA_PREFAULT;
+	schunksz = ALGN(ssz + MBLOCKSZ, HUGEPAGESZ) - MBLOCKSZ;
+	dchunksz = ALGN(dsz + MBLOCKSZ, HUGEPAGESZ) - MBLOCKSZ;
+    } else {
+	mflags = 0;
+	schunksz = ALGN(ssz, STRUCT_AL);
+	dchunksz = ALGN(dsz, STRUCT_AL);
+    }
     if (schunksz != 0) {
 	if (schunk != (chunk *) NULL) {
 	    schunk->next = sflist;
@@ -900,11 +1118,10 @@ bool m_check()
  */
 void m_purge()
 {
-    char *p;
-
 # ifdef DEBUG
     while (hlist != (header *) NULL) {
 	char buf[160];
+	char *p;
 	size_t n;
 
 	n = (hlist->size & SIZE_MASK) - MOFFSET;
@@ -931,15 +1148,13 @@ void m_purge()
 # endif
 
     /* purge dynamic memory */
-    while (dlist != (char *) NULL) {
-	p = dlist;
-	dlist = *(char **) p;
-	free(p);
-    }
-    memset(dchunks, '\0', sizeof(dchunks));
-    dchunk = (chunk *) NULL;
+    delmem(&dlist, mretain);
+    memset(dclasses, '\0', sizeof(dclasses));
+    eslabs = (slab *) NULL;
+    slabmem = slabend = (char *) NULL;
     dtree = (spnode *) NULL;
     mstat.dmemsize = mstat.dmemused = 0;
+    mstat.slabsize = mstat.slabused = 0;
     dmem = FALSE;
 
     if (schunksz != 0 &&
@@ -961,6 +1176,22 @@ void m_purge()
  */
 allocinfo *m_info()
 {
+    sclass *sc;
+    slabinfo *si;
+    int i;
+
+    mstat.slabs = si = dslabs;
+    for (i = 0, sc = dclasses; i < DCHUNKS; i++, sc++) {
+	if (sc->nslabs != 0) {
+	    si->size = MOFFSET + (i + 1) * STRUCT_AL;
+	    si->nslabs = sc->nslabs;
+	    si->nchunks = sc->nslabs * ((SLABSZ - SLABOFFSET) / si->size);
+	    si->nused = sc->nused;
+	    si++;
+	}
+    }
+    mstat.nslabs = si - dslabs;
+
     return &mstat;
 }
 
@@ -971,10 +1202,9 @@ allocinfo *m_info()
  */
 void m_finish()
 {
-    char *p;
-
     schunksz = 0;
     dchunksz = 0;
+    mretain = 0;
 
     /* purge dynamic memory */
 # ifdef DEBUG
@@ -983,11 +1213,9 @@ void m_finish()
     m_purge();
 
     /* purge static memory */
-    while (slist != (char *) NULL) {
-	p = slist;
-	slist = *(char **) p;
-	free(p);
-    }
+    delmem(&slist, 0);
+    mstat.retained = 0;
+    delmem(&rlist, 0);
     memset(schunks, '\0', sizeof(schunks));
     memset(lchunks, '\0', sizeof(lchunks));
     nlc = 0;
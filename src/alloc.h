@@ -45,7 +45,7 @@ extern char *m_realloc	(char*, size_t, size_t);
 
 # define FREE(mem)	m_free((char *) (mem))
 
-extern void  m_init	(size_t, size_t);
+extern void  m_init	(size_t, size_t, bool, size_t);
 extern void  m_free	(char*);
 extern void  m_dynamic	(void);
 extern void  m_static	(void);
@@ -53,11 +53,25 @@ extern bool  m_check	(void);
 extern void  m_purge	(void);
 extern void  m_finish	(void);
 
+typedef struct {
+    size_t size;	/* chunk size */
+    Uint nslabs;	/* # slabs */
+    Uint nchunks;	/* # chunks in slabs */
+    Uint nused;		/* # chunks in use */
+} slabinfo;
+
 typedef struct {
     size_t smemsize;	/* static memory size */
     size_t smemused;	/* static memory used */
     size_t dmemsize;	/* dynamic memory used */
     size_t dmemused;	/* dynamic memory used */
+    size_t slabsize;	/* dynamic memory in slabs */
+    size_t slabused;	/* slab memory in use */
+    size_t hugesize;	/* memory backed by huge pages */
+    size_t retained;	/* free memory retained after a purge */
+    size_t released;	/* memory returned to the system */
+    int nslabs;		/* # size classes with slabs */
+    slabinfo *slabs;	/* per size class slab information */
 } allocinfo;
 
 extern allocinfo *m_info (void);
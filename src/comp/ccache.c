@@ -0,0 +1,912 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# define INCLUDE_FILE_IO
+# include "comp.h"
+# include "str.h"
+# include "array.h"
+# include "object.h"
+# include "xfloat.h"
+# include "interpret.h"
+# include "data.h"
+# include "table.h"
+# include "control.h"
+# include "path.h"
+# include "ccache.h"
+# include "version.h"
+
+/*
+ * A persistent cache of compiled programs.  Each entry holds the control
+ * block tables of one object, together with digests of the source files
+ * it was compiled from and of the programs it inherits, and the answers
+ * the driver object gave to include_file() and inherit_program().  An
+ * entry is only used if all of those are unchanged; the driver object is
+ * asked again before an entry is used.
+ */
+
+# define CC_MAGIC	"DGDC"
+# define CC_FORMAT	1		/* entry format */
+# define CC_DEPENDS	64		/* max # files a program depends on */
+# define CC_QUERIES	64		/* max # driver object queries */
+
+# define CQ_INCLUDE	0		/* include_file() */
+# define CQ_INHERIT	1		/* inherit_program() */
+
+# define FNV_BASIS	(((Uuint) 0xcbf29ce4 << 32) | 0x84222325)
+# define FNV_PRIME	(((Uuint) 0x100 << 32) | 0x1b3)
+
+typedef struct {
+    char magic[4];		/* CC_MAGIC */
+    Uint format;		/* CC_FORMAT */
+    Uuint ident;		/* compiler configuration digest */
+    short flags;		/* control block flags */
+    short ninherits;		/* # inherited objects */
+    uindex imapsz;		/* inherit map size */
+    Uint progsize;		/* program text size */
+    unsigned short nstrings;	/* # strings */
+    unsigned short nfuncdefs;	/* # function definitions */
+    unsigned short nvardefs;	/* # variable definitions */
+    unsigned short nclassvars;	/* # class variable definitions */
+    uindex nfuncalls;		/* # function calls */
+    unsigned short nsymbols;	/* # symbols */
+    unsigned short nvariables;	/* # variables */
+    unsigned short ndepends;	/* # files depended on */
+    unsigned short nqueries;	/* # driver object queries */
+} ccheader;
+
+typedef struct {
+    char *file;			/* file name */
+    bool present;		/* file found? */
+    bool digested;		/* digest known? */
+    Uuint digest;		/* digest of file contents */
+} ccdepend;
+
+typedef struct {
+    char type;			/* CQ_INCLUDE or CQ_INHERIT */
+    char flag;			/* include found, or private inherit */
+    char *from;			/* file being compiled */
+    char *file;			/* path asked for */
+    char *result;		/* path or object name returned */
+} ccquery;
+
+static char *directory;		/* cache directory, or NULL */
+static char *auto_name;		/* name of auto object */
+static char *driver_name;	/* name of driver object */
+static char *include;		/* standard include file */
+static char **paths;		/* include paths */
+static int typechecking;	/* typechecking level */
+static bool identified;		/* configuration digest computed? */
+static Uuint ident;		/* configuration digest */
+static bool active;		/* collecting dependencies? */
+static bool cacheable;		/* current program can be cached? */
+static ccdepend depends[CC_DEPENDS]; /* files the program depends on */
+static int ndepends;		/* # dependencies */
+static ccquery queries[CC_QUERIES]; /* driver object queries */
+static int nqueries;		/* # driver object queries */
+static char *buffer;		/* entry buffer */
+static Uint bufsz;		/* entry buffer size */
+static Uint buflen;		/* entry buffer length */
+
+/*
+ * NAME:	ccache->init()
+ * DESCRIPTION:	initialize the compiled program cache
+ */
+void cc_init(char *dir, char *a, char *d, char *i, char **p, int tc)
+{
+    directory = dir;
+    auto_name = a;
+    driver_name = d;
+    include = i;
+    paths = p;
+    typechecking = tc;
+}
+
+/*
+ * NAME:	fnv()
+ * DESCRIPTION:	add a block of memory to a digest
+ */
+static Uuint fnv(Uuint h, char *p, Uint len)
+{
+    while (len != 0) {
+	h = (h ^ UCHAR(*p++)) * FNV_PRIME;
+	--len;
+    }
+    return h;
+}
+
+/*
+ * NAME:	fnvstr()
+ * DESCRIPTION:	add a string to a digest
+ */
+static Uuint fnvstr(Uuint h, char *str)
+{
+    return fnv(h, str, strlen(str) + 1);
+}
+
+/*
+ * NAME:	fnvint()
+ * DESCRIPTION:	add an integer to a digest
+ */
+static Uuint fnvint(Uuint h, Uint n)
+{
+    return fnv(h, (char *) &n, sizeof(Uint));
+}
+
+/*
+ * NAME:	ccache->ident()
+ * DESCRIPTION:	compute the digest of the compiler configuration
+ */
+static void cc_ident()
+{
+    Uuint h;
+    char **p;
+    int i;
+
+    h = fnvstr(FNV_BASIS, VERSION);
+    h = fnvint(h, sizeof(ccheader));
+    h = fnvint(h, sizeof(dinherit));
+    h = fnvint(h, sizeof(dfuncdef));
+    h = fnvint(h, sizeof(dvardef));
+    h = fnvint(h, sizeof(dsymbol));
+    h = fnvint(h, sizeof(ssizet));
+    h = fnvint(h, typechecking);
+    h = fnvstr(h, auto_name);
+    h = fnvstr(h, driver_name);
+    h = fnvstr(h, include);
+    for (p = paths; *p != (char *) NULL; p++) {
+	h = fnvstr(h, *p);
+    }
+
+    /* kfun calls are compiled as indices in the kfun table */
+    for (i = 0; i < nkfun; i++) {
+	h = fnvstr(h, kftab[i].name);
+	if (kftab[i].proto != (char *) NULL) {
+	    h = fnv(h, kftab[i].proto, PROTO_SIZE(kftab[i].proto));
+	}
+    }
+    h = fnv(h, kfind, 128 + nkfun - KF_BUILTINS);
+
+    ident = h;
+    identified = TRUE;
+}
+
+/*
+ * NAME:	ccache->program()
+ * DESCRIPTION:	compute the digest of a program
+ */
+static Uuint cc_program(control *ctrl)
+{
+    Uuint h;
+    dinherit *inh;
+    dfuncdef *func;
+    dvardef *var;
+    dsymbol *symb;
+    string *str;
+    Uint n;
+
+    h = FNV_BASIS;
+    for (n = ctrl->ninherits, inh = ctrl->inherits; n != 0; --n, inh++) {
+	if (n != 1) {
+	    h = fnvstr(h, OBJR(inh->oindex)->chain.name);
+	}
+	h = fnvint(h, inh->progoffset);
+	h = fnvint(h, inh->funcoffset);
+	h = fnvint(h, inh->varoffset);
+	h = fnvint(h, inh->priv);
+    }
+    h = fnv(h, ctrl->imap, ctrl->imapsz);
+
+    h = fnv(h, d_get_prog(ctrl), ctrl->progsize);
+    for (n = 0; n < ctrl->nstrings; n++) {
+	str = d_get_strconst(ctrl, ctrl->ninherits - 1, n);
+	h = fnv(h, str->text, str->len + 1);
+    }
+    for (n = ctrl->nfuncdefs, func = d_get_funcdefs(ctrl); n != 0;
+	 --n, func++) {
+	h = fnvint(h, UCHAR(func->class));
+	h = fnvint(h, UCHAR(func->inherit));
+	h = fnvint(h, func->index);
+	h = fnvint(h, func->offset);
+    }
+    for (n = ctrl->nvardefs, var = d_get_vardefs(ctrl); n != 0; --n, var++) {
+	h = fnvint(h, UCHAR(var->class));
+	h = fnvint(h, UCHAR(var->type));
+	h = fnvint(h, UCHAR(var->inherit));
+	h = fnvint(h, var->index);
+    }
+    if (ctrl->classvars != (char *) NULL) {
+	h = fnv(h, ctrl->classvars, ctrl->nclassvars * (Uint) 3);
+    }
+    h = fnv(h, d_get_funcalls(ctrl), ctrl->nfuncalls * (Uint) 2);
+    for (n = ctrl->nsymbols, symb = d_get_symbols(ctrl); n != 0;
+	 --n, symb++) {
+	h = fnvint(h, UCHAR(symb->inherit));
+	h = fnvint(h, UCHAR(symb->index));
+	h = fnvint(h, symb->next);
+    }
+    return fnvint(h, ctrl->nvariables);
+}
+
+/*
+ * NAME:	ccache->file()
+ * DESCRIPTION:	compute the digest of a file; return FALSE if it cannot be
+ *		read, or if it was modified at or after the given time
+ */
+static bool cc_file(char *file, Uint time, Uuint *digest)
+{
+    struct stat sbuf;
+    char *text;
+    int fd;
+    bool ok;
+
+    fd = P_open(file, O_RDONLY | O_BINARY, 0);
+    if (fd < 0) {
+	return FALSE;
+    }
+    P_fstat(fd, &sbuf);
+    if ((sbuf.st_mode & S_IFMT) != S_IFREG ||
+	(time != 0 && sbuf.st_mtime >= time)) {
+	P_close(fd);
+	return FALSE;
+    }
+
+    text = ALLOC(char, sbuf.st_size + 1);
+    ok = (P_read(fd, text, (int) sbuf.st_size) == sbuf.st_size);
+    P_close(fd);
+    if (ok) {
+	*digest = fnv(fnvint(FNV_BASIS, (Uint) sbuf.st_size), text,
+		       (Uint) sbuf.st_size);
+    }
+    FREE(text);
+    return ok;
+}
+
+/*
+ * NAME:	ccache->absent()
+ * DESCRIPTION:	check that a file cannot be included
+ */
+static bool cc_absent(char *file)
+{
+    struct stat sbuf;
+
+    return (P_stat(file, &sbuf) < 0 || (sbuf.st_mode & S_IFMT) != S_IFREG);
+}
+
+/*
+ * NAME:	ccache->path()
+ * DESCRIPTION:	construct the name of the cache entry for an object
+ */
+static char *cc_path(char *buf, char *name, char *suffix)
+{
+    Uuint h;
+
+    h = fnvstr(FNV_BASIS, name);
+    sprintf(buf, "%s/%08lx%08lx%s", directory, (unsigned long) (h >> 32),
+	    (unsigned long) (h & 0xffffffffL), suffix);
+    return buf;
+}
+
+/*
+ * NAME:	ccache->clear()
+ * DESCRIPTION:	forget collected dependencies
+ */
+static void cc_clear()
+{
+    while (ndepends != 0) {
+	FREE(depends[--ndepends].file);
+    }
+    while (nqueries != 0) {
+	FREE(queries[--nqueries].from);
+    }
+    active = FALSE;
+}
+
+/*
+ * NAME:	ccache->start()
+ * DESCRIPTION:	start collecting dependencies for a new compilation attempt;
+ *		return TRUE if the cache is enabled
+ */
+bool cc_start()
+{
+    cc_clear();
+    if (directory == (char *) NULL) {
+	return FALSE;
+    }
+    if (!identified) {
+	cc_ident();
+    }
+    active = cacheable = TRUE;
+    return TRUE;
+}
+
+/*
+ * NAME:	ccache->depend()
+ * DESCRIPTION:	the current program depends on a file, which may or may not
+ *		have been found, and which may already have been read in full;
+ *		NULL means source not read from a file
+ */
+void cc_depend(char *file, string *str, int present)
+{
+    int i;
+
+    if (!active || !cacheable) {
+	return;
+    }
+    if (file == (char *) NULL) {
+	cacheable = FALSE;
+	return;
+    }
+    for (i = 0; i < ndepends; i++) {
+	if (strcmp(depends[i].file, file) == 0) {
+	    return;
+	}
+    }
+    if (ndepends == CC_DEPENDS) {
+	cacheable = FALSE;
+	return;
+    }
+    depends[ndepends].file = strcpy(ALLOC(char, strlen(file) + 1), file);
+    depends[ndepends].present = present;
+    if (str != (string *) NULL) {
+	depends[ndepends].digested = TRUE;
+	depends[ndepends].digest = fnv(fnvint(FNV_BASIS, str->len), str->text,
+				       str->len);
+    } else {
+	depends[ndepends].digested = FALSE;
+    }
+    ndepends++;
+}
+
+/*
+ * NAME:	ccache->query()
+ * DESCRIPTION:	remember the answer to a driver object query
+ */
+static void cc_query(int type, int flag, char *from, char *file,
+		     char *result)
+{
+    ccquery *q;
+    Uint len1, len2, len3;
+
+    if (!active || !cacheable) {
+	return;
+    }
+    if (nqueries == CC_QUERIES) {
+	cacheable = FALSE;
+	return;
+    }
+    q = &queries[nqueries++];
+    q->type = type;
+    q->flag = flag;
+    len1 = strlen(from) + 1;
+    len2 = strlen(file) + 1;
+    len3 = strlen(result) + 1;
+    q->from = ALLOC(char, len1 + len2 + len3);
+    q->file = q->from + len1;
+    q->result = q->file + len2;
+    memcpy(q->from, from, len1);
+    memcpy(q->file, file, len2);
+    memcpy(q->result, result, len3);
+}
+
+/*
+ * NAME:	ccache->include()
+ * DESCRIPTION:	the driver object translated an include path, to NULL if
+ *		the file cannot be included
+ */
+void cc_include(char *from, char *file, char *path)
+{
+    if (path != (char *) NULL) {
+	cc_query(CQ_INCLUDE, TRUE, from, file, path);
+    } else {
+	cc_query(CQ_INCLUDE, FALSE, from, file, "");
+    }
+}
+
+/*
+ * NAME:	ccache->inherit()
+ * DESCRIPTION:	the driver object selected an object to inherit
+ */
+void cc_inherit(char *from, char *file, int priv, char *name)
+{
+    cc_query(CQ_INHERIT, priv, from, file, name);
+}
+
+/*
+ * NAME:	put()
+ * DESCRIPTION:	append to the entry buffer
+ */
+static void put(char *p, Uint len)
+{
+    if (len == 0) {
+	return;
+    }
+    if (buflen + len > bufsz) {
+	char *buf;
+
+	bufsz = (buflen + len) * 2;
+	buf = ALLOC(char, bufsz);
+	if (buflen != 0) {
+	    memcpy(buf, buffer, buflen);
+	}
+	if (buffer != (char *) NULL) {
+	    FREE(buffer);
+	}
+	buffer = buf;
+    }
+    memcpy(buffer + buflen, p, len);
+    buflen += len;
+}
+
+/*
+ * NAME:	ccache->save()
+ * DESCRIPTION:	save a freshly compiled program in the cache
+ */
+void cc_save(char *file, control *ctrl, Uint time)
+{
+    char path[STRINGSZ + 24], tmp[STRINGSZ + 24];
+    Uuint ddigests[CC_DEPENDS], *idigests;
+    ccheader header;
+    dinherit *inh;
+    object *obj;
+    ssizet len;
+    int i, fd;
+    bool ok;
+
+    if (!active || !cacheable || strlen(directory) + 22 >= STRINGSZ) {
+	cc_clear();
+	return;
+    }
+
+    /*
+     * source files not read in full must not have changed since compilation
+     * started
+     */
+    for (i = 0; i < ndepends; i++) {
+	if (depends[i].digested) {
+	    ddigests[i] = depends[i].digest;
+	} else if (depends[i].present) {
+	    if (!cc_file(depends[i].file, time, &ddigests[i])) {
+		cc_clear();
+		return;
+	    }
+	} else if (cc_absent(depends[i].file)) {
+	    ddigests[i] = 0;
+	} else {
+	    cc_clear();
+	    return;
+	}
+    }
+
+    /*
+     * inherited programs must be the current versions
+     */
+    idigests = ALLOCA(Uuint, ctrl->ninherits);
+    for (i = 0, inh = ctrl->inherits; i < ctrl->ninherits - 1; i++, inh++) {
+	obj = OBJR(inh->oindex);
+	if (o_find(obj->chain.name, OACC_READ) != obj) {
+	    AFREE(idigests);
+	    cc_clear();
+	    return;
+	}
+	idigests[i] = cc_program(o_control(obj));
+    }
+
+    header.magic[0] = CC_MAGIC[0];
+    header.magic[1] = CC_MAGIC[1];
+    header.magic[2] = CC_MAGIC[2];
+    header.magic[3] = CC_MAGIC[3];
+    header.format = CC_FORMAT;
+    header.ident = ident;
+    header.flags = ctrl->flags & CTRL_UNDEFINED;
+    header.ninherits = ctrl->ninherits;
+    header.imapsz = ctrl->imapsz;
+    header.progsize = ctrl->progsize;
+    header.nstrings = ctrl->nstrings;
+    header.nfuncdefs = ctrl->nfuncdefs;
+    header.nvardefs = ctrl->nvardefs;
+    header.nclassvars = ctrl->nclassvars;
+    header.nfuncalls = ctrl->nfuncalls;
+    header.nsymbols = ctrl->nsymbols;
+    header.nvariables = ctrl->nvariables;
+    header.ndepends = ndepends;
+    header.nqueries = nqueries;
+
+    buffer = (char *) NULL;
+    bufsz = buflen = 0;
+    put((char *) &header, sizeof(ccheader));
+    put(file, strlen(file) + 1);
+    for (i = 0; i < ndepends; i++) {
+	put((char *) &ddigests[i], sizeof(Uuint));
+	put(&depends[i].present, 1);
+	put(depends[i].file, strlen(depends[i].file) + 1);
+    }
+    for (i = 0; i < nqueries; i++) {
+	put(&queries[i].type, 1);
+	put(&queries[i].flag, 1);
+	put(queries[i].from, strlen(queries[i].from) + 1);
+	put(queries[i].file, strlen(queries[i].file) + 1);
+	put(queries[i].result, strlen(queries[i].result) + 1);
+    }
+    cc_clear();
+    for (i = 0, inh = ctrl->inherits; i < ctrl->ninherits - 1; i++, inh++) {
+	obj = OBJR(inh->oindex);
+	put((char *) &idigests[i], sizeof(Uuint));
+	put(obj->chain.name, strlen(obj->chain.name) + 1);
+    }
+    AFREE(idigests);
+
+    put((char *) ctrl->inherits, ctrl->ninherits * sizeof(dinherit));
+    put(ctrl->imap, ctrl->imapsz);
+    put(ctrl->prog, ctrl->progsize);
+    for (i = 0; i < ctrl->nstrings; i++) {
+	len = ctrl->strings[i]->len;
+	put((char *) &len, sizeof(ssizet));
+	put(ctrl->strings[i]->text, len);
+    }
+    put((char *) ctrl->funcdefs, ctrl->nfuncdefs * sizeof(dfuncdef));
+    put((char *) ctrl->vardefs, ctrl->nvardefs * sizeof(dvardef));
+    put(ctrl->classvars, ctrl->nclassvars * (Uint) 3);
+    put(ctrl->funcalls, ctrl->nfuncalls * (Uint) 2);
+    put((char *) ctrl->symbols, ctrl->nsymbols * sizeof(dsymbol));
+
+    /*
+     * write to a temporary file first, so a cache entry is always complete
+     */
+    fd = P_open(cc_path(tmp, file, ".tmp"),
+		O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0644);
+    if (fd >= 0) {
+	ok = (P_write(fd, buffer, buflen) == buflen);
+	P_close(fd);
+	if (!ok || P_rename(tmp, cc_path(path, file, ".dgc")) < 0) {
+	    P_unlink(tmp);
+	}
+    }
+    FREE(buffer);
+    buffer = (char *) NULL;
+    bufsz = 0;
+}
+
+/*
+ * NAME:	get()
+ * DESCRIPTION:	take the next block from the entry buffer, or return NULL
+ *		if there is not enough left
+ */
+static char *get(Uint len)
+{
+    char *p;
+
+    if (len > bufsz - buflen) {
+	return (char *) NULL;
+    }
+    p = buffer + buflen;
+    buflen += len;
+    return p;
+}
+
+/*
+ * NAME:	getstr()
+ * DESCRIPTION:	take the next string from the entry buffer, or return NULL
+ */
+static char *getstr()
+{
+    char *p, *q;
+
+    p = buffer + buflen;
+    q = (char *) memchr(p, '\0', bufsz - buflen);
+    if (q == (char *) NULL) {
+	return (char *) NULL;
+    }
+    buflen += q - p + 1;
+    return p;
+}
+
+/*
+ * NAME:	ccache->inherited()
+ * DESCRIPTION:	check that inherit_program() still selects the same object
+ */
+static bool cc_inherited(frame *f, char *from, char *file, int priv,
+			 char *name)
+{
+    bool same;
+
+    PUSH_STRVAL(f, str_new(NULL, strlen(from) + 1L));
+    f->sp->u.string->text[0] = '/';
+    strcpy(f->sp->u.string->text + 1, from);
+    PUSH_STRVAL(f, str_new(file, (long) strlen(file)));
+    PUSH_INTVAL(f, priv);
+    if (!call_driver_object(f, "inherit_program", 3)) {
+	f->sp++;
+	return FALSE;
+    }
+    same = (f->sp->type == T_OBJECT &&
+	    strcmp(OBJR(f->sp->oindex)->chain.name, name) == 0);
+    i_del_value(f->sp++);
+    return same;
+}
+
+/*
+ * NAME:	ccache->queries()
+ * DESCRIPTION:	ask the driver object the queries stored in a cache entry
+ *		again, and check that the answers are unchanged
+ */
+static bool cc_queries(frame *f, int n)
+{
+    char buf[STRINGSZ], *save, *p, *from, *file, *result, *path;
+    string **strs;
+    Uint size, len;
+    int nstr;
+    bool same;
+
+    /*
+     * the driver object may compile objects, which use the cache as well
+     */
+    save = buffer;
+    size = bufsz;
+    if (ec_push((ec_ftn) NULL)) {
+	FREE(save);
+	buffer = (char *) NULL;
+	bufsz = 0;
+	error((char *) NULL);	/* pass on error */
+    }
+
+    for (same = TRUE; n != 0 && same; --n) {
+	if ((p=get(2)) == (char *) NULL ||
+	    (from=getstr()) == (char *) NULL ||
+	    (file=getstr()) == (char *) NULL ||
+	    (result=getstr()) == (char *) NULL) {
+	    same = FALSE;
+	    break;
+	}
+	len = buflen;
+
+	if (p[0] == CQ_INCLUDE) {
+	    path = path_include(buf, from, file, &strs, &nstr);
+	    if (strs != (string **) NULL) {
+		/* included from strings, which are not cached */
+		while (nstr != 0) {
+		    str_del(strs[--nstr]);
+		}
+		FREE(strs);
+		same = FALSE;
+	    } else if (p[1]) {
+		same = (path != (char *) NULL && strcmp(path, result) == 0);
+	    } else {
+		same = (path == (char *) NULL);
+	    }
+	} else {
+	    same = cc_inherited(f, from, file, p[1], result);
+	}
+
+	buffer = save;
+	bufsz = size;
+	buflen = len;
+    }
+    ec_pop();
+
+    return same;
+}
+
+/*
+ * NAME:	ccache->entry()
+ * DESCRIPTION:	read and validate a cache entry, and return the inherited
+ *		objects, or NULL
+ */
+static uindex *cc_entry(frame *f, char *file, ccheader *header)
+{
+    char path[STRINGSZ + 24];
+    struct stat sbuf;
+    uindex *oindices;
+    object *obj;
+    char *p, *name;
+    Uuint digest, d;
+    int fd, i;
+
+    /* read entry */
+    fd = P_open(cc_path(path, file, ".dgc"), O_RDONLY | O_BINARY, 0);
+    if (fd < 0) {
+	return (uindex *) NULL;
+    }
+    P_fstat(fd, &sbuf);
+    if ((sbuf.st_mode & S_IFMT) != S_IFREG ||
+	sbuf.st_size < (off_t) sizeof(ccheader) || sbuf.st_size > 0x7fffffffL) {
+	P_close(fd);
+	return (uindex *) NULL;
+    }
+    buffer = ALLOC(char, bufsz = sbuf.st_size);
+    buflen = 0;
+    if (P_read(fd, buffer, (int) bufsz) != bufsz) {
+	P_close(fd);
+	return (uindex *) NULL;
+    }
+    P_close(fd);
+
+    /* check header */
+    memcpy(header, get(sizeof(ccheader)), sizeof(ccheader));
+    if (memcmp(header->magic, CC_MAGIC, 4) != 0 ||
+	header->format != CC_FORMAT || header->ident != ident ||
+	header->ninherits <= 0 || header->ninherits > UCHAR_MAX ||
+	(name=getstr()) == (char *) NULL || strcmp(name, file) != 0) {
+	return (uindex *) NULL;
+    }
+
+    /* check source files */
+    for (i = header->ndepends; i != 0; --i) {
+	if ((p=get(sizeof(Uuint) + 1)) == (char *) NULL ||
+	    (name=getstr()) == (char *) NULL) {
+	    return (uindex *) NULL;
+	}
+	memcpy(&digest, p, sizeof(Uuint));
+	if (p[sizeof(Uuint)]) {
+	    if (!cc_file(name, 0, &d) || d != digest) {
+		return (uindex *) NULL;
+	    }
+	} else if (!cc_absent(name)) {
+	    return (uindex *) NULL;
+	}
+    }
+
+    /* check the answers of the driver object */
+    if (!cc_queries(f, header->nqueries)) {
+	return (uindex *) NULL;
+    }
+
+    /* check inherited programs */
+    oindices = ALLOC(uindex, header->ninherits);
+    for (i = 0; i < header->ninherits - 1; i++) {
+	if ((p=get(sizeof(Uuint))) == (char *) NULL ||
+	    (name=getstr()) == (char *) NULL ||
+	    (obj=o_find(name, OACC_READ)) == (object *) NULL ||
+	    (obj->flags & O_DRIVER)) {
+	    FREE(oindices);
+	    return (uindex *) NULL;
+	}
+	memcpy(&digest, p, sizeof(Uuint));
+	if (cc_program(o_control(obj)) != digest) {
+	    FREE(oindices);
+	    return (uindex *) NULL;
+	}
+	oindices[i] = obj->index;
+    }
+    oindices[i] = UINDEX_MAX;
+
+    return oindices;
+}
+
+/*
+ * NAME:	ccache->load()
+ * DESCRIPTION:	load a program from the cache, or return NULL
+ */
+control *cc_load(frame *f, char *file)
+{
+    ccheader header;
+    uindex *oindices;
+    control *ctrl;
+    dinherit *inh;
+    char *p;
+    ssizet len;
+    int i;
+
+    if (strlen(directory) + 22 >= STRINGSZ) {
+	return (control *) NULL;
+    }
+
+    buffer = (char *) NULL;
+    ctrl = (control *) NULL;
+    oindices = cc_entry(f, file, &header);
+    if (oindices != (uindex *) NULL &&
+	(p=get(header.ninherits * sizeof(dinherit))) != (char *) NULL) {
+	ctrl = d_new_control();
+	ctrl->flags = header.flags;
+	ctrl->ninherits = header.ninherits;
+	inh = ctrl->inherits = ALLOC(dinherit, header.ninherits);
+	memcpy(inh, p, header.ninherits * sizeof(dinherit));
+	for (i = 0; i < header.ninherits; i++) {
+	    inh[i].oindex = oindices[i];
+	}
+	ctrl->progindex = header.ninherits - 1;
+	ctrl->compiled = P_time();	/* loaded now, as if compiled */
+	ctrl->nvariables = header.nvariables;
+
+	/*
+	 * restore tables; on failure, the partial control block is freed
+	 */
+	if ((p=get(ctrl->imapsz = header.imapsz)) == (char *) NULL) {
+	    goto corrupt;
+	}
+	memcpy(ctrl->imap = ALLOC(char, header.imapsz), p, header.imapsz);
+	if ((p=get(ctrl->progsize = header.progsize)) == (char *) NULL) {
+	    goto corrupt;
+	}
+	if (header.progsize != 0) {
+	    memcpy(ctrl->prog = ALLOC(char, header.progsize), p,
+		   header.progsize);
+	}
+	if ((ctrl->nstrings = header.nstrings) != 0) {
+	    ctrl->strings = ALLOC(string*, header.nstrings);
+	    memset(ctrl->strings, '\0', header.nstrings * sizeof(string*));
+	    for (i = 0; i < header.nstrings; i++) {
+		if ((p=get(sizeof(ssizet))) == (char *) NULL) {
+		    goto corrupt;
+		}
+		memcpy(&len, p, sizeof(ssizet));
+		if ((p=get(len)) == (char *) NULL) {
+		    goto corrupt;
+		}
+		str_ref(ctrl->strings[i] = str_new(p, (long) len));
+		ctrl->strsize += len;
+	    }
+	}
+	if ((p=get(header.nfuncdefs * sizeof(dfuncdef))) == (char *) NULL) {
+	    goto corrupt;
+	}
+	if ((ctrl->nfuncdefs = header.nfuncdefs) != 0) {
+	    ctrl->funcdefs = ALLOC(dfuncdef, header.nfuncdefs);
+	    memcpy(ctrl->funcdefs, p, header.nfuncdefs * sizeof(dfuncdef));
+	}
+	if ((p=get(header.nvardefs * sizeof(dvardef))) == (char *) NULL) {
+	    goto corrupt;
+	}
+	if ((ctrl->nvardefs = header.nvardefs) != 0) {
+	    ctrl->vardefs = ALLOC(dvardef, header.nvardefs);
+	    memcpy(ctrl->vardefs, p, header.nvardefs * sizeof(dvardef));
+	}
+	if ((p=get(header.nclassvars * (Uint) 3)) == (char *) NULL ||
+	    (header.nclassvars != 0 && header.nvardefs == 0)) {
+	    goto corrupt;
+	}
+	if ((ctrl->nclassvars = header.nclassvars) != 0) {
+	    ctrl->classvars = ALLOC(char, header.nclassvars * 3);
+	    memcpy(ctrl->classvars, p, header.nclassvars * 3);
+	}
+	if ((p=get(header.nfuncalls * (Uint) 2)) == (char *) NULL) {
+	    goto corrupt;
+	}
+	if ((ctrl->nfuncalls = header.nfuncalls) != 0) {
+	    ctrl->funcalls = ALLOC(char, header.nfuncalls * 2L);
+	    memcpy(ctrl->funcalls, p, header.nfuncalls * 2L);
+	}
+	if ((p=get(header.nsymbols * sizeof(dsymbol))) == (char *) NULL ||
+	    buflen != bufsz) {
+	    goto corrupt;
+	}
+	if ((ctrl->nsymbols = header.nsymbols) != 0) {
+	    ctrl->symbols = ALLOC(dsymbol, header.nsymbols);
+	    memcpy(ctrl->symbols, p, header.nsymbols * sizeof(dsymbol));
+	}
+	ctrl_mkvtypes(ctrl);
+    }
+
+    if (oindices != (uindex *) NULL) {
+	FREE(oindices);
+    }
+    if (buffer != (char *) NULL) {
+	FREE(buffer);
+	buffer = (char *) NULL;
+	bufsz = 0;
+    }
+    return ctrl;
+
+corrupt:
+    d_del_control(ctrl);
+    FREE(oindices);
+    FREE(buffer);
+    buffer = (char *) NULL;
+    bufsz = 0;
+    return (control *) NULL;
+}
@@ -0,0 +1,26 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+extern void	 cc_init	(char*, char*, char*, char*, char**, int);
+extern bool	 cc_start	(void);
+extern void	 cc_depend	(char*, string*, int);
+extern void	 cc_include	(char*, char*, char*);
+extern void	 cc_inherit	(char*, char*, int, char*);
+extern control	*cc_load	(frame*, char*);
+extern void	 cc_save	(char*, control*, Uint);
@@ -33,6 +33,7 @@
 # include "optimize.h"
 # include "codegen.h"
 # include "compile.h"
+# include "ccache.h"
 # include <stdarg.h>
 
 # define COND_CHUNK	16
@@ -425,7 +426,7 @@ extern int nerrors;			/* # of errors during parsing */
  * NAME:	compile->init()
  * DESCRIPTION:	initialize the compiler
  */
-void c_init(char *a, char *d, char *i, char **p, int tc)
+void c_init(char *a, char *d, char *i, char **p, int tc, char *cache)
 {
     stricttc = (tc == 2);
     node_init(stricttc);
@@ -435,6 +436,9 @@ void c_init(char *a, char *d, char *i, char **p, int tc)
     include = i;
     paths = p;
     typechecking = tc | cg_compiled();
+    if (!cg_compiled()) {
+	cc_init(cache, a, d, i, p, tc);
+    }
 }
 
 /*
@@ -450,6 +454,7 @@ static void c_clear()
     block_clear();
     cond_clear();
     node_clear();
+    opt_clear();
     seen_decls = FALSE;
     nesting = 0;
 }
@@ -464,6 +469,7 @@ bool c_typechecking()
 }
 
 static long ncompiled;		/* # objects compiled */
+static compinfo cinfo;		/* last compilation */
 
 /*
  * NAME:	compile->inherit()
@@ -524,6 +530,7 @@ bool c_inherit(char *file, node *label, int priv)
 	    if (ncomp != ncompiled) {
 		return FALSE;	/* objects compiled inside inherit_program() */
 	    }
+	    cc_inherit(current->file, buf, priv, obj->chain.name);
 	} else {
 	    /* precompiling */
 	    f->sp++;
@@ -551,6 +558,29 @@ bool c_inherit(char *file, node *label, int priv)
 
 extern int yyparse (void);
 
+/*
+ * NAME:	compile->verify()
+ * DESCRIPTION:	check that a compiled program can be installed
+ */
+static void c_verify(object *obj)
+{
+    if (obj != (object *) NULL) {
+	if (obj->count == 0) {
+	    error("Object destructed during recompilation");
+	}
+	if (O_UPGRADING(obj)) {
+	    error("Object recompiled during recompilation");
+	}
+	if (O_INHERITED(obj)) {
+	    /* inherited */
+	    error("Object inherited during recompilation");
+	}
+    }
+    if (!o_space()) {
+	error("Too many objects");
+    }
+}
+
 /*
  * NAME:	compile->compile()
  * DESCRIPTION:	compile an LPC file
@@ -560,6 +590,9 @@ object *c_compile(frame *f, char *file, object *obj, string **strs,
 {
     context c;
     char file_c[STRINGSZ + 2];
+    control *ctrl;
+    long ncomp;
+    Uuint start;
 
     if (iflag) {
 	context *cc;
@@ -604,6 +637,7 @@ object *c_compile(frame *f, char *file, object *obj, string **strs,
     }
 
     for (;;) {
+	start = P_utime();
 	if (c_autodriver() != 0) {
 	    ctrl_init();
 	} else {
@@ -636,39 +670,58 @@ object *c_compile(frame *f, char *file, object *obj, string **strs,
 	    ctrl_inherit(c.frame, file, aobj, (string *) NULL, FALSE);
 	}
 
-	if (strs != (string **) NULL) {
-	    pp_init(file_c, paths, strs, nstr, 1);
-	} else if (!pp_init(file_c, paths, (string **) NULL, 0, 1)) {
-	    error("Could not compile \"/%s\"", file_c);
-	}
-	if (!tk_include(include, (string **) NULL, 0)) {
-	    error("Could not include \"/%s\"", include);
+	ctrl = (control *) NULL;
+	ncomp = ncompiled;
+	if (strs == (string **) NULL && cc_start()) {
+	    /*
+	     * try the compiled program cache first
+	     */
+	    c_verify(obj);
+	    ctrl = cc_load(f, file);
+	    if (ncomp != ncompiled) {
+		/* objects compiled inside inherit_program(): try again */
+		if (ctrl != (control *) NULL) {
+		    d_del_control(ctrl);
+		}
+		pp_clear();
+		ctrl_clear();
+		c_clear();
+		continue;
+	    }
 	}
 
-	cg_init(c.prev != (context *) NULL);
-	if (yyparse() == 0 && ctrl_chkfuncs()) {
-	    control *ctrl;
+	if (ctrl == (control *) NULL) {
+	    if (strs != (string **) NULL) {
+		pp_init(file_c, paths, strs, nstr, 1);
+	    } else if (!pp_init(file_c, paths, (string **) NULL, 0, 1)) {
+		error("Could not compile \"/%s\"", file_c);
+	    }
+	    if (!tk_include(include, (string **) NULL, 0)) {
+		error("Could not include \"/%s\"", include);
+	    }
 
-	    if (obj != (object *) NULL) {
-		if (obj->count == 0) {
-		    error("Object destructed during recompilation");
+	    cg_init(c.prev != (context *) NULL);
+	    if (yyparse() != 0 || !ctrl_chkfuncs()) {
+		if (nerrors == 0) {
+		    /* another try */
+		    pp_clear();
+		    ctrl_clear();
+		    c_clear();
+		    continue;
 		}
-		if (O_UPGRADING(obj)) {
-		    error("Object recompiled during recompilation");
-		}
-		if (O_INHERITED(obj)) {
-		    /* inherited */
-		    error("Object inherited during recompilation");
-		}
-	    }
-	    if (!o_space()) {
-		error("Too many objects");
+
+		/* compilation failed */
+		error("Failed to compile \"/%s\"", file_c);
 	    }
+	    c_verify(obj);
 
 	    /*
 	     * successfully compiled
 	     */
 	    ec_pop();
+	    tk_info(&cinfo.included, &cinfo.cached);
+	    opt_info(&cinfo.inlined);
+	    cinfo.loaded = FALSE;
 	    pp_clear();
 
 	    if (!seen_decls) {
@@ -678,41 +731,54 @@ object *c_compile(frame *f, char *file, object *obj, string **strs,
 		ctrl_create();
 	    }
 	    ctrl = ctrl_construct();
-	    ctrl_clear();
-	    c_clear();
-	    current = c.prev;
-
-	    if (obj == (object *) NULL) {
-		/* new object */
-		obj = o_new(file, ctrl);
-		if (strcmp(file, driver_object) == 0) {
-		    obj->flags |= O_DRIVER;
-		} else if (strcmp(file, auto_object) == 0) {
-		    obj->flags |= O_AUTO;
-		}
-	    } else {
-		unsigned short *vmap;
-
-		/* recompiled object */
-		o_upgrade(obj, ctrl, f);
-		vmap = ctrl_varmap(obj->ctrl, ctrl);
-		if (vmap != (unsigned short *) NULL) {
-		    d_set_varmap(obj->ctrl, ctrl->nvariables + 1, vmap);
-		}
+	    if (strs == (string **) NULL && ncomp == ncompiled) {
+		cc_save(file, ctrl, (Uint) (start / 1000000));
 	    }
-	    return obj;
-	} else if (nerrors == 0) {
-	    /* another try */
+	} else {
+	    /*
+	     * loaded from the cache
+	     */
+	    ec_pop();
+	    cinfo.included = cinfo.cached = cinfo.inlined = 0;
+	    cinfo.loaded = TRUE;
 	    pp_clear();
-	    ctrl_clear();
-	    c_clear();
+	}
+	ctrl_clear();
+	c_clear();
+	current = c.prev;
+	cinfo.time = (Uint) (P_utime() - start);
+
+	if (obj == (object *) NULL) {
+	    /* new object */
+	    obj = o_new(file, ctrl);
+	    if (strcmp(file, driver_object) == 0) {
+		obj->flags |= O_DRIVER;
+	    } else if (strcmp(file, auto_object) == 0) {
+		obj->flags |= O_AUTO;
+	    }
 	} else {
-	    /* compilation failed */
-	    error("Failed to compile \"/%s\"", file_c);
+	    unsigned short *vmap;
+
+	    /* recompiled object */
+	    o_upgrade(obj, ctrl, f);
+	    vmap = ctrl_varmap(obj->ctrl, ctrl);
+	    if (vmap != (unsigned short *) NULL) {
+		d_set_varmap(obj->ctrl, ctrl->nvariables + 1, vmap);
+	    }
 	}
+	return obj;
     }
 }
 
+/*
+ * NAME:	compile->info()
+ * DESCRIPTION:	return statistics about the last compilation
+ */
+compinfo *c_info()
+{
+    return &cinfo;
+}
+
 /*
  * NAME:	compile->autodriver()
  * DESCRIPTION:	indicate if the auto object or driver object is being
@@ -1029,6 +1095,7 @@ void c_funcbody(node *n)
 	break;
     }
 
+    opt_define(n);
     n = opt_stmt(n, &depth);
     if (depth > 0x7fff) {
 	c_error("function uses too much stack space");
@@ -17,8 +17,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-extern void	 c_init		(char*, char*, char*, char**, int);
+typedef struct {
+    Uint time;			/* compilation time in microseconds */
+    Uint included;		/* # files included */
+    Uint cached;		/* # included files taken from the cache */
+    Uint loaded;		/* loaded from the compiled program cache? */
+    Uint inlined;		/* # function calls inlined */
+} compinfo;
+
+extern void	 c_init		(char*, char*, char*, char**, int, char*);
 extern object	*c_compile	(frame*, char*, object*, string**, int, int);
+extern compinfo *c_info		(void);
 extern bool	 c_upgrade	(object**, unsigned int);
 extern int	 c_autodriver	(void);
 extern void	 c_error	(char *, ...);
@@ -1439,6 +1439,37 @@ char *ctrl_fcall(string *str, string **cfstr, long *call, int typechecking)
     return proto;
 }
 
+/*
+ * NAME:	control->fdef()
+ * DESCRIPTION:	return the prototype of the function being defined, and
+ *		the direct call to it
+ */
+char *ctrl_fdef(long *call)
+{
+    *call = ((long) DFCALL << 24) | ((long) ninherits << 8) | fdef;
+    return functions[fdef].proto;
+}
+
+/*
+ * NAME:	control->ifunc()
+ * DESCRIPTION:	return the inherited function called directly, if its
+ *		program is available
+ */
+char *ctrl_ifunc(long call, control **ctrl)
+{
+    short inherit;
+
+    inherit = (call >> 8) & 0xff;
+    if (inherit == ninherits) {
+	return (char *) NULL;
+    }
+    *ctrl = OBJR(newctrl->inherits[inherit].oindex)->ctrl;
+    if ((*ctrl)->flags & (CTRL_COMPILED | CTRL_OLDVM)) {
+	return (char *) NULL;
+    }
+    return (*ctrl)->prog + (*ctrl)->funcdefs[call & 0xff].offset;
+}
+
 /*
  * NAME:	control->gencall()
  * DESCRIPTION:	generate a function call
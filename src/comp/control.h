@@ -30,6 +30,8 @@ extern void		 ctrl_dvar	(string*, unsigned int,
 					   unsigned int, string*);
 extern char		*ctrl_ifcall	(string*, char*, string**, long*);
 extern char		*ctrl_fcall	(string*, string**, long*, int);
+extern char		*ctrl_fdef	(long*);
+extern char		*ctrl_ifunc	(long, control**);
 extern unsigned short	 ctrl_gencall	(long);
 extern unsigned short	 ctrl_var	(string*, long*, string**);
 extern int		 ctrl_ninherits	(void);
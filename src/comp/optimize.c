@@ -125,6 +125,435 @@ void opt_init()
     kf_call_trace = ((long) KFCALL << 24) | kf_func("call_trace");
 }
 
+
+# define INLINE_SIZE	16	/* max. # nodes in an inlined expression */
+
+typedef struct {
+    int nargs;			/* # parameters */
+    char *args;			/* parameter types */
+    node *expr;			/* returned expression */
+    int size;			/* # nodes in expression */
+} inlfunc;
+
+static inlfunc inlines[UCHAR_MAX];	/* inlinable functions */
+static Uint ninlined;			/* # calls inlined */
+
+/*
+ * NAME:	optimize->isize()
+ * DESCRIPTION:	return the size of an expression that can be inlined, or
+ *		a size larger than INLINE_SIZE if it cannot
+ */
+static int opt_isize(node *n)
+{
+    switch (n->type) {
+    case N_FLOAT:
+    case N_GLOBAL:
+    case N_INT:
+    case N_LOCAL:
+    case N_NIL:
+    case N_STR:
+	return 1;
+
+    case N_CAST:
+    case N_NOT:
+    case N_TOFLOAT:
+    case N_TOINT:
+    case N_TOSTRING:
+    case N_TST:
+	return 1 + opt_isize(n->l.left);
+
+    case N_ADD:
+    case N_ADD_INT:
+    case N_ADD_FLOAT:
+    case N_AND:
+    case N_AND_INT:
+    case N_DIV:
+    case N_DIV_INT:
+    case N_DIV_FLOAT:
+    case N_EQ:
+    case N_EQ_INT:
+    case N_EQ_FLOAT:
+    case N_GE:
+    case N_GE_INT:
+    case N_GE_FLOAT:
+    case N_GT:
+    case N_GT_INT:
+    case N_GT_FLOAT:
+    case N_INDEX:
+    case N_LAND:
+    case N_LE:
+    case N_LE_INT:
+    case N_LE_FLOAT:
+    case N_LOR:
+    case N_LSHIFT:
+    case N_LSHIFT_INT:
+    case N_LT:
+    case N_LT_INT:
+    case N_LT_FLOAT:
+    case N_MOD:
+    case N_MOD_INT:
+    case N_MULT:
+    case N_MULT_INT:
+    case N_MULT_FLOAT:
+    case N_NE:
+    case N_NE_INT:
+    case N_NE_FLOAT:
+    case N_OR:
+    case N_OR_INT:
+    case N_PAIR:
+    case N_QUEST:
+    case N_RSHIFT:
+    case N_RSHIFT_INT:
+    case N_SUB:
+    case N_SUB_INT:
+    case N_SUB_FLOAT:
+    case N_XOR:
+    case N_XOR_INT:
+	return 1 + opt_isize(n->l.left) + opt_isize(n->r.right);
+
+    default:
+	return INLINE_SIZE + 1;
+    }
+}
+
+/*
+ * NAME:	optimize->icopy()
+ * DESCRIPTION:	copy an expression to be inlined later
+ */
+static node *opt_icopy(node *n, node **copy)
+{
+    node *m;
+
+    m = (*copy)++;
+    *m = *n;
+    switch (n->type) {
+    case N_FLOAT:
+    case N_INT:
+    case N_NIL:
+	break;
+
+    case N_LOCAL:
+	m->l.left = (node *) NULL;	/* parameter, replaced by argument */
+	break;
+
+    case N_STR:
+	str_ref(m->l.string);
+	m->r.right = (node *) NULL;
+	break;
+
+    case N_GLOBAL:
+	m->l.left = opt_icopy(n->l.left, copy);	/* name */
+	break;
+
+    case N_CAST:
+    case N_NOT:
+    case N_TOFLOAT:
+    case N_TOINT:
+    case N_TOSTRING:
+    case N_TST:
+	m->l.left = opt_icopy(n->l.left, copy);
+	break;
+
+    default:
+	m->l.left = opt_icopy(n->l.left, copy);
+	m->r.right = opt_icopy(n->r.right, copy);
+	break;
+    }
+
+    return m;
+}
+
+/*
+ * NAME:	optimize->iexpand()
+ * DESCRIPTION:	create an instance of an inlined expression
+ */
+static node *opt_iexpand(node *n, node **args, unsigned int line)
+{
+    node *m;
+
+    if (n->type == N_LOCAL && args != (node **) NULL) {
+	/* parameter */
+	return opt_iexpand(args[n->r.number], (node **) NULL, line);
+    }
+
+    m = node_new(line);
+    *m = *n;
+    m->line = line;
+    switch (n->type) {
+    case N_FLOAT:
+    case N_INT:
+    case N_NIL:
+	break;
+
+    case N_STR:
+	str_ref(m->l.string);
+	m->r.right = (node *) NULL;
+	break;
+
+    case N_GLOBAL:
+    case N_LOCAL:
+	if (n->l.left != (node *) NULL) {
+	    m->l.left = opt_iexpand(n->l.left, (node **) NULL, line);
+	}
+	break;
+
+    case N_CAST:
+    case N_NOT:
+    case N_TOFLOAT:
+    case N_TOINT:
+    case N_TOSTRING:
+    case N_TST:
+	m->l.left = opt_iexpand(n->l.left, args, line);
+	break;
+
+    default:
+	m->l.left = opt_iexpand(n->l.left, args, line);
+	m->r.right = opt_iexpand(n->r.right, args, line);
+	break;
+    }
+
+    return m;
+}
+
+/*
+ * NAME:	optimize->define()
+ * DESCRIPTION:	remember the body of a function that is called directly,
+ *		if it consists of a single return statement that is small
+ *		enough to be inlined
+ */
+void opt_define(node *n)
+{
+    char *proto, *args;
+    long call;
+    int i, size;
+    inlfunc *func;
+    node *copy;
+
+    proto = ctrl_fdef(&call);
+    if (!((PROTO_CLASS(proto) & (C_PRIVATE | C_NOMASK)) ||
+	  ((PROTO_CLASS(proto) & C_STATIC) && ctrl_ninherits() == 0)) ||
+	(PROTO_CLASS(proto) & (C_ATOMIC | C_ELLIPSIS)) ||
+	PROTO_VARGS(proto) != 0 || (PROTO_FTYPE(proto) & T_TYPE) == T_CLASS) {
+	return;	/* not a direct call, or not a simple one */
+    }
+    if (n->type != N_COMPOUND || n->r.right != (node *) NULL ||
+	n->l.left->type != N_RETURN) {
+	return;	/* more than a single return statement */
+    }
+    n = n->l.left->l.left;
+    size = opt_isize(n);
+    if (size > INLINE_SIZE) {
+	return;
+    }
+    args = PROTO_ARGS(proto);
+    for (i = PROTO_NARGS(proto); i > 0; --i) {
+	if ((*args++ & T_TYPE) == T_CLASS) {
+	    return;
+	}
+    }
+
+    func = &inlines[call & 0xff];
+    func->nargs = PROTO_NARGS(proto);
+    if (func->nargs != 0) {
+	func->args = (char *) memcpy(ALLOC(char, func->nargs),
+				     PROTO_ARGS(proto), func->nargs);
+    }
+    copy = func->expr = ALLOC(node, 2 * size);	/* room for names */
+    opt_icopy(n, &copy);
+    func->size = copy - func->expr;
+}
+
+/*
+ * NAME:	optimize->iconst()
+ * DESCRIPTION:	return the constant returned by an inherited function, if
+ *		that is all it does
+ */
+static node *opt_iconst(node *n)
+{
+    char *pc;
+    control *ctrl;
+    unsigned short u, u2;
+    Int l;
+    xfloat flt;
+
+    pc = ctrl_ifunc(n->r.number, &ctrl);
+    if (pc == (char *) NULL || PROTO_NARGS(pc) != 0 || PROTO_VARGS(pc) != 0 ||
+	(PROTO_CLASS(pc) & (C_ATOMIC | C_COMPILED | C_UNDEFINED))) {
+	return (node *) NULL;
+    }
+    pc += PROTO_SIZE(pc) + 3;
+    if (FETCH2U(pc, u) < 2) {
+	return (node *) NULL;
+    }
+
+    switch (FETCH1U(pc) & I_EINSTR_MASK) {
+    case I_PUSH_INT1:
+	if (n->mod != T_INT) {
+	    return (node *) NULL;
+	}
+	n = node_int((Int) FETCH1S(pc));
+	break;
+
+    case I_PUSH_INT4:
+	if (n->mod != T_INT) {
+	    return (node *) NULL;
+	}
+	n = node_int(FETCH4S(pc, l));
+	break;
+
+    case I_PUSH_FLOAT6:
+	if (n->mod != T_FLOAT) {
+	    return (node *) NULL;
+	}
+	FETCH2U(pc, u);
+	flt.high = u;
+	flt.low = FETCH4U(pc, l);
+	n = node_float(&flt);
+	break;
+
+    case I_PUSH_STRING:
+	if (n->mod != T_STRING) {
+	    return (node *) NULL;
+	}
+	n = node_str(d_get_strconst(ctrl, ctrl->ninherits - 1, FETCH1U(pc)));
+	break;
+
+    case I_PUSH_NEAR_STRING:
+	if (n->mod != T_STRING) {
+	    return (node *) NULL;
+	}
+	u = FETCH1U(pc);
+	n = node_str(d_get_strconst(ctrl, u, FETCH1U(pc)));
+	break;
+
+    case I_PUSH_FAR_STRING:
+	if (n->mod != T_STRING) {
+	    return (node *) NULL;
+	}
+	u = FETCH1U(pc);
+	n = node_str(d_get_strconst(ctrl, u, FETCH2U(pc, u2)));
+	break;
+
+    default:
+	return (node *) NULL;
+    }
+
+    if ((FETCH1U(pc) & I_EINSTR_MASK) != I_RETURN) {
+	return (node *) NULL;	/* node is freed with the others */
+    }
+    return n;
+}
+
+/*
+ * NAME:	optimize->inline()
+ * DESCRIPTION:	replace a direct function call by the expression that it
+ *		returns, if possible
+ */
+static bool opt_inline(node **m)
+{
+    node *n, *args, *argv[MAX_LOCALS];
+    inlfunc *func;
+    int i, type;
+
+    n = *m;
+    args = n->l.left->r.right;
+    if (((n->r.number >> 8) & 0xff) != ctrl_ninherits()) {
+	/*
+	 * inherited function which may return a constant
+	 */
+	if (args != (node *) NULL) {
+	    return FALSE;
+	}
+	args = opt_iconst(n);
+	if (args == (node *) NULL) {
+	    return FALSE;
+	}
+	args->line = n->line;
+	*m = args;
+	ninlined++;
+	return TRUE;
+    }
+
+    func = &inlines[n->r.number & 0xff];
+    if (func->expr == (node *) NULL || func->expr->mod != n->mod) {
+	return FALSE;
+    }
+
+    /*
+     * arguments must be simple, and of the parameter type
+     */
+    for (i = 0; i < func->nargs; i++) {
+	if (args == (node *) NULL) {
+	    return FALSE;
+	}
+	if (args->type == N_PAIR) {
+	    argv[i] = args->l.left;
+	    args = args->r.right;
+	} else {
+	    argv[i] = args;
+	    args = (node *) NULL;
+	}
+	switch (argv[i]->type) {
+	case N_FLOAT:
+	case N_GLOBAL:
+	case N_INT:
+	case N_LOCAL:
+	case N_NIL:
+	case N_STR:
+	    type = UCHAR(func->args[i]);
+	    if (type == T_MIXED || type == argv[i]->mod) {
+		break;
+	    }
+	    /* fall through */
+	default:
+	    return FALSE;
+	}
+    }
+    if (args != (node *) NULL) {
+	return FALSE;
+    }
+
+    *m = opt_iexpand(func->expr, argv, n->line);
+    ninlined++;
+    return TRUE;
+}
+
+/*
+ * NAME:	optimize->clear()
+ * DESCRIPTION:	forget about inlinable functions
+ */
+void opt_clear()
+{
+    inlfunc *func;
+    node *n;
+    int i, j;
+
+    for (i = UCHAR_MAX, func = inlines; i > 0; --i, func++) {
+	if (func->expr != (node *) NULL) {
+	    for (j = func->size, n = func->expr; j > 0; --j, n++) {
+		if (n->type == N_STR) {
+		    str_del(n->l.string);
+		}
+	    }
+	    FREE(func->expr);
+	    func->expr = (node *) NULL;
+	    if (func->nargs != 0) {
+		FREE(func->args);
+	    }
+	}
+    }
+    ninlined = 0;
+}
+
+/*
+ * NAME:	optimize->info()
+ * DESCRIPTION:	return the number of function calls inlined
+ */
+void opt_info(Uint *inlined)
+{
+    *inlined = ninlined;
+}
+
 static Uint opt_expr (node**, int);
 
 /*
@@ -1443,6 +1872,9 @@ static Uint opt_expr(node **m, int pop)
 	return opt_lvalue(n->l.left) + 1;
 
     case N_FUNC:
+	if ((n->r.number >> 24) == DFCALL && opt_inline(m)) {
+	    return opt_expr(m, pop);
+	}
 	m = &n->l.left->r.right;
 	n = *m;
 	if (n == (node *) NULL) {
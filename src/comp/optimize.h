@@ -18,4 +18,7 @@
  */
 
 extern void  opt_init	(void);
+extern void  opt_define	(node*);
+extern void  opt_clear	(void);
+extern void  opt_info	(Uint*);
 extern node *opt_stmt	(node*, Uint*);
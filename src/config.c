@@ -68,61 +68,68 @@ static config conf[] = {
 # define CALL_OUTS	4
 				{ "call_outs",		INT_CONST, FALSE, FALSE,
 							0, UINDEX_MAX - 1 },
-# define CREATE		5
+# define COMPILE_CACHE	5
+				{ "compile_cache",	STRING_CONST },
+# define CREATE		6
 				{ "create",		STRING_CONST },
-# define DIRECTORY	6
+# define DIRECTORY	7
 				{ "directory",		STRING_CONST },
-# define DRIVER_OBJECT	7
+# define DRIVER_OBJECT	8
 				{ "driver_object",	STRING_CONST, TRUE },
-# define DUMP_FILE	8
+# define DUMP_FILE	9
 				{ "dump_file",		STRING_CONST },
-# define DUMP_INTERVAL	9
+# define DUMP_INTERVAL	10
 				{ "dump_interval",	INT_CONST },
-# define DYNAMIC_CHUNK	10
+# define DYNAMIC_CHUNK	11
 				{ "dynamic_chunk",	INT_CONST, FALSE, FALSE,
 							1024 },
-# define ED_TMPFILE	11
+# define DYNAMIC_RETAIN	12
+				{ "dynamic_retain",	INT_CONST },
+# define ED_TMPFILE	13
 				{ "ed_tmpfile",		STRING_CONST },
-# define EDITORS	12
+# define EDITORS	14
 				{ "editors",		INT_CONST, FALSE, FALSE,
 							0, EINDEX_MAX },
-# define HOTBOOT	13
+# define HOTBOOT	15
 				{ "hotboot",		'(' },
-# define INCLUDE_DIRS	14
+# define HUGE_PAGES	16
+				{ "huge_pages",		INT_CONST, FALSE, FALSE,
+							0, 1 },
+# define INCLUDE_DIRS	17
 				{ "include_dirs",	'(' },
-# define INCLUDE_FILE	15
+# define INCLUDE_FILE	18
 				{ "include_file",	STRING_CONST, TRUE },
-# define MODULES	16
+# define MODULES	19
 				{ "modules",		'(' },
-# define OBJECTS	17
+# define OBJECTS	20
 				{ "objects",		INT_CONST, FALSE, FALSE,
 							2, UINDEX_MAX },
-# define PORTS		18
+# define PORTS		21
 				{ "ports",		INT_CONST, FALSE, FALSE,
 							1, 32 },
-# define SECTOR_SIZE	19
+# define SECTOR_SIZE	22
 				{ "sector_size",	INT_CONST, FALSE, FALSE,
 							512, 65535 },
-# define STATIC_CHUNK	20
+# define STATIC_CHUNK	23
 				{ "static_chunk",	INT_CONST },
-# define SWAP_FILE	21
+# define SWAP_FILE	24
 				{ "swap_file",		STRING_CONST },
-# define SWAP_FRAGMENT	22
+# define SWAP_FRAGMENT	25
 				{ "swap_fragment",	INT_CONST, FALSE, FALSE,
 							0, SW_UNUSED },
-# define SWAP_SIZE	23
+# define SWAP_SIZE	26
 				{ "swap_size",		INT_CONST, FALSE, FALSE,
 							1024, SW_UNUSED },
-# define TELNET_PORT	24
+# define TELNET_PORT	27
 				{ "telnet_port",	'[', FALSE, FALSE,
 							1, USHRT_MAX },
-# define TYPECHECKING	25
+# define TYPECHECKING	28
 				{ "typechecking",	INT_CONST, FALSE, FALSE,
 							0, 2 },
-# define USERS		26
+# define USERS		29
 				{ "users",		INT_CONST, FALSE, FALSE,
 							1, EINDEX_MAX },
-# define NR_OPTIONS	27
+# define NR_OPTIONS	30
 };
 
 
@@ -1032,7 +1039,8 @@ static bool conf_config()
     }
 
     for (l = 0; l < NR_OPTIONS; l++) {
-	if (!conf[l].set && l != HOTBOOT && l != MODULES) {
+	if (!conf[l].set && l != COMPILE_CACHE && l != DYNAMIC_RETAIN &&
+	    l != HOTBOOT && l != HUGE_PAGES && l != MODULES) {
 	    char buffer[64];
 
 #ifndef NETWORK_EXTENSIONS
@@ -1159,6 +1167,14 @@ static bool conf_includes()
     cputs("# define ST_PRECOMPILED\t24\t/* precompiled objects */\012");
     cputs("# define ST_TELNETPORTS\t25\t/* telnet ports */\012");
     cputs("# define ST_BINARYPORTS\t26\t/* binary ports */\012");
+    cputs("# define ST_SLABSIZE\t27\t/* dynamic memory in slabs */\012");
+    cputs("# define ST_SLABUSED\t28\t/* slab memory in use */\012");
+    cputs("# define ST_SLABS\t29\t/* slab size classes */\012");
+    cputs("# define ST_HUGESIZE\t30\t/* memory backed by huge pages */\012");
+    cputs("# define ST_MEMRETAINED\t31\t/* free memory retained */\012");
+    cputs("# define ST_MEMRELEASED\t32\t/* memory returned to the system */\012");
+    cputs("# define ST_GCLAP\t33\t/* last garbage collection lap */\012");
+    cputs("# define ST_COMPILE\t34\t/* last compilation */\012");
 
     cputs("\012# define O_COMPILETIME\t0\t/* time of compilation */\012");
     cputs("# define O_PROGSIZE\t1\t/* program size of object */\012");
@@ -1169,6 +1185,9 @@ static bool conf_includes()
     cputs("# define O_UNDEFINED\t6\t/* undefined functions */\012");
     cputs("# define O_INHERITED\t7\t/* object inherited? */\012");
     cputs("# define O_INSTANTIATED\t8\t/* object instantiated? */\012");
+    cputs("# define O_STRBYTES\t9\t/* bytes used by strings */\012");
+    cputs("# define O_ARRBYTES\t10\t/* bytes used by arrays/mappings */\012");
+    cputs("# define O_SWAPBYTES\t11\t/* bytes used on swap device */\012");
 
     cputs("\012# define CO_HANDLE\t0\t/* callout handle */\012");
     cputs("# define CO_FUNCTION\t1\t/* function name */\012");
@@ -1498,13 +1517,18 @@ bool conf_init(char *configfile, char *snapshot, char *snapshot2, char *module,
 	   conf[DRIVER_OBJECT].u.str,
 	   conf[INCLUDE_FILE].u.str,
 	   dirs,
-	   (int) conf[TYPECHECKING].u.num);
+	   (int) conf[TYPECHECKING].u.num,
+	   (conf[COMPILE_CACHE].set) ?
+	    conf[COMPILE_CACHE].u.str : (char *) NULL);
 
     m_dynamic();
 
     /* initialize memory manager */
     m_init((size_t) conf[STATIC_CHUNK].u.num,
-	   (size_t) conf[DYNAMIC_CHUNK].u.num);
+	   (size_t) conf[DYNAMIC_CHUNK].u.num,
+	   conf[HUGE_PAGES].set && conf[HUGE_PAGES].u.num != 0,
+	   (conf[DYNAMIC_RETAIN].set) ?
+	    (size_t) conf[DYNAMIC_RETAIN].u.num : 0);
 
     /*
      * create include files
@@ -1665,6 +1689,28 @@ static void putval(value *v, size_t n)
     }
 }
 
+/*
+ * NAME:	slab_info()
+ * DESCRIPTION:	return the occupancy of a slab size class
+ */
+static array *slab_info(dataspace *data, slabinfo *si)
+{
+    array *a;
+    value *v;
+
+    a = arr_new(data, 4L);
+    v = a->elts;
+    PUT_INTVAL(v, si->size);
+    v++;
+    PUT_INTVAL(v, si->nslabs);
+    v++;
+    PUT_INTVAL(v, si->nused);
+    v++;
+    PUT_INTVAL(v, si->nchunks - si->nused);
+
+    return a;
+}
+
 /*
  * NAME:	config->statusi()
  * DESCRIPTION:	return resource usage information
@@ -1673,6 +1719,9 @@ bool conf_statusi(frame *f, Int idx, value *v)
 {
     char *version;
     uindex ncoshort, ncolong;
+    allocinfo *info;
+    gcinfo *gc;
+    compinfo *comp;
     array *a;
     Uint t;
     int i;
@@ -1806,6 +1855,65 @@ bool conf_statusi(frame *f, Int idx, value *v)
 	}
 	break;
 
+    case 27:	/* ST_SLABSIZE */
+	putval(v, m_info()->slabsize);
+	break;
+
+    case 28:	/* ST_SLABUSED */
+	putval(v, m_info()->slabused);
+	break;
+
+    case 29:	/* ST_SLABS */
+	info = m_info();
+	a = arr_new(f->data, (long) info->nslabs);
+	PUT_ARRVAL(v, a);
+	for (i = 0, v = a->elts; i < info->nslabs; i++, v++) {
+	    PUT_ARRVAL(v, slab_info(f->data, &info->slabs[i]));
+	}
+	break;
+
+    case 30:	/* ST_HUGESIZE */
+	putval(v, m_info()->hugesize);
+	break;
+
+    case 31:	/* ST_MEMRETAINED */
+	putval(v, m_info()->retained);
+	break;
+
+    case 32:	/* ST_MEMRELEASED */
+	putval(v, m_info()->released);
+	break;
+
+    case 33:	/* ST_GCLAP */
+	gc = d_gcinfo();
+	a = arr_new(f->data, 4L);
+	PUT_ARRVAL(v, a);
+	v = a->elts;
+	PUT_INTVAL(v, gc->laps);
+	v++;
+	PUT_INTVAL(v, gc->time);
+	v++;
+	PUT_INTVAL(v, gc->ncollected);
+	v++;
+	PUT_INTVAL(v, gc->ndeferred);
+	break;
+
+    case 34:	/* ST_COMPILE */
+	comp = c_info();
+	a = arr_new(f->data, 5L);
+	PUT_ARRVAL(v, a);
+	v = a->elts;
+	PUT_INTVAL(v, comp->time);
+	v++;
+	PUT_INTVAL(v, comp->included);
+	v++;
+	PUT_INTVAL(v, comp->cached);
+	v++;
+	PUT_INTVAL(v, comp->loaded);
+	v++;
+	PUT_INTVAL(v, comp->inlined);
+	break;
+
     default:
 	return FALSE;
     }
@@ -1828,8 +1936,8 @@ array *conf_status(frame *f)
 	arr_del(a);
 	error((char *) NULL);
     }
-    a = arr_ext_new(f->data, 27L);
-    for (i = 0, v = a->elts; i < 27; i++, v++) {
+    a = arr_ext_new(f->data, 35L);
+    for (i = 0, v = a->elts; i < 35; i++, v++) {
 	conf_statusi(f, i, v);
     }
     ec_pop();
@@ -1846,6 +1954,8 @@ bool conf_objecti(dataspace *data, object *obj, Int idx, value *v)
     control *ctrl;
     object *prog;
     array *a;
+    long strbytes, arrbytes;
+    Uint swapsize;
 
     prog = (obj->flags & O_MASTER) ? obj : OBJR(obj->u_master);
     ctrl = (O_UPGRADING(prog)) ? OBJR(prog->prev)->ctrl : o_control(prog);
@@ -1905,6 +2015,21 @@ bool conf_objecti(dataspace *data, object *obj, Int idx, value *v)
 	PUT_INTVAL(v, O_HASDATA(obj));
 	break;
 
+    case 9:	/* O_STRBYTES */
+	o_datasize(obj, &strbytes, &arrbytes, &swapsize);
+	putval(v, (strbytes > 0) ? (size_t) strbytes : 0);
+	break;
+
+    case 10:	/* O_ARRBYTES */
+	o_datasize(obj, &strbytes, &arrbytes, &swapsize);
+	putval(v, (arrbytes > 0) ? (size_t) arrbytes : 0);
+	break;
+
+    case 11:	/* O_SWAPBYTES */
+	o_datasize(obj, &strbytes, &arrbytes, &swapsize);
+	putval(v, swapsize);
+	break;
+
     default:
 	return FALSE;
     }
@@ -1922,13 +2047,13 @@ array *conf_object(dataspace *data, object *obj)
     Int i;
     array *a;
 
-    a = arr_ext_new(data, 9L);
+    a = arr_ext_new(data, 12L);
     if (ec_push((ec_ftn) NULL)) {
 	arr_ref(a);
 	arr_del(a);
 	error((char *) NULL);
     }
-    for (i = 0, v = a->elts; i < 9; i++, v++) {
+    for (i = 0, v = a->elts; i < 12; i++, v++) {
 	conf_objecti(data, obj, i, v);
     }
     ec_pop();
@@ -71,6 +71,7 @@ typedef unsigned char eindex;
 
 /* editor */
 # define NR_EDBUFS	3	/* # buffers in editor cache (>= 3) */
+# define ED_MEMSIZE	1048576	/* editor text kept in memory, per buffer */
 /*# define TMPFILE_SIZE	2097152 */ /* max. editor tmpfile size */
 
 /* lexical scanner */
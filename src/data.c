@@ -89,6 +89,7 @@ static void ref_rhs(dataspace *data, value *rhs)
 	} else {
 	    /* not in this object: ref imported string */
 	    data->plane->schange++;
+	    data->strbytes += STR_BYTES(str);
 	}
 	break;
 
@@ -105,9 +106,11 @@ static void ref_rhs(dataspace *data, value *rhs)
 	    } else {
 		/* ref new array */
 		data->plane->achange++;
+		data->arrbytes += ARR_BYTES(arr);
 	    }
 	} else {
 	    /* not in this object: ref imported array */
+	    data->arrbytes += ARR_BYTES(arr);
 	    if (data->plane->imports++ == 0 && ifirst != data &&
 		data->iprev == (dataspace *) NULL) {
 		/* add to imports list */
@@ -139,6 +142,7 @@ static void del_lhs(dataspace *data, value *lhs)
 	if (str->primary != (strref *) NULL && str->primary->data == data) {
 	    /* in this object */
 	    if (--(str->primary->ref) == 0) {
+		data->strbytes -= STR_BYTES(str);
 		str->primary->str = (string *) NULL;
 		str->primary = (strref *) NULL;
 		str_del(str);
@@ -148,6 +152,7 @@ static void del_lhs(dataspace *data, value *lhs)
 	} else {
 	    /* not in this object: deref imported string */
 	    data->plane->schange--;
+	    data->strbytes -= STR_BYTES(str);
 	}
 	break;
 
@@ -161,6 +166,7 @@ static void del_lhs(dataspace *data, value *lhs)
 		/* swapped in */
 		data->plane->flags |= MOD_ARRAYREF;
 		if ((--(arr->primary->ref) & ~ARR_MOD) == 0) {
+		    data->arrbytes -= ARR_BYTES(arr);
 		    d_get_elts(arr);
 		    arr->primary->arr = (array *) NULL;
 		    arr->primary = &arr->primary->plane->alocal;
@@ -170,11 +176,13 @@ static void del_lhs(dataspace *data, value *lhs)
 	    } else {
 		/* deref new array */
 		data->plane->achange--;
+		data->arrbytes -= ARR_BYTES(arr);
 	    }
 	} else {
 	    /* not in this object: deref imported array */
 	    data->plane->imports--;
 	    data->plane->achange--;
+	    data->arrbytes -= ARR_BYTES(arr);
 	}
 	break;
     }
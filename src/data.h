@@ -223,8 +223,26 @@ struct _dataspace_ {
     dataplane *plane;		/* current value plane */
 
     struct _parser_ *parser;	/* parse_string data */
+
+    unsigned short gcage;	/* # garbage collection laps survived */
+    Uint gclap;			/* last lap with full garbage collection */
+
+    long strbytes;		/* bytes used by strings */
+    long arrbytes;		/* bytes used by arrays and mappings */
+    Uint swapsize;		/* bytes used on the swap device */
 };
 
+# define STR_BYTES(s)		((long) sizeof(string) + (s)->len)
+# define ARR_BYTES(a)		((long) sizeof(array) + \
+				 (a)->size * (long) sizeof(value))
+
+typedef struct {
+    Uint laps;			/* # completed garbage collection laps */
+    Uint time;			/* microseconds spent in last lap */
+    Uint ncollected;		/* # dataspaces collected in last lap */
+    Uint ndeferred;		/* # dataspaces deferred in last lap */
+} gcinfo;
+
 # define THISPLANE(a)		((a)->plane == (a)->data->plane)
 # define SAMEPLANE(d1, d2)	((d1)->plane->level == (d2)->plane->level)
 
@@ -238,6 +256,7 @@ extern control	       *d_new_control	 (void);
 extern dataspace       *d_new_dataspace  (object*);
 extern control	       *d_load_control	 (object*);
 extern dataspace       *d_load_dataspace (object*);
+extern void		d_get_datasize	 (object*, long*, long*, Uint*);
 extern void		d_ref_control	 (control*);
 extern void		d_ref_dataspace  (dataspace*);
 
@@ -255,6 +274,7 @@ extern value	       *d_get_elts	 (array*);
 extern void		d_get_callouts	 (dataspace*);
 
 extern sector		d_swapout	 (unsigned int);
+extern gcinfo	       *d_gcinfo	 (void);
 extern void		d_upgrade_mem	 (object*, object*);
 extern control	       *d_restore_ctrl	 (object*,
 					  void(*)(char*, sector*, Uint, Uint));
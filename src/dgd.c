@@ -30,6 +30,7 @@
 # include "comm.h"
 # include "node.h"
 # include "compile.h"
+# include "table.h"
 # include <stdarg.h>
 
 static uindex dindex;		/* driver object index */
@@ -102,6 +103,7 @@ void endthread()
 	 */
 	d_swapout(1);
 	arr_freeall();
+	kf_purge();
 	m_purge();
 	swap = FALSE;
     }
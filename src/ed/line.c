@@ -22,8 +22,11 @@
 # include "line.h"
 
 /*
- *   The blocks in a line buffer are written in a temporary file, and read back
- * if needed. There are at least 3 temporary file buffers: a write buffer and
+ *   The blocks in a line buffer are written to memory, and once ED_MEMSIZE
+ * bytes have been used, to a temporary file which is only created then; blocks
+ * in the tmpfile are read back if needed. Offsets of blocks are the same as if
+ * everything was written to the tmpfile, with the blocks kept in memory coming
+ * first. There are at least 3 temporary file buffers: a write buffer and
  * two read buffers. If a block is not in one of those buffers, it is loaded
  * in the read buffer that wasn't used in the last read buffer access.
  *   The write buffer is filled with blocks on one side and text on the other.
@@ -58,6 +61,7 @@
 
 # define BLOCK_SIZE	(2 * (MAX_LINE_SIZE))
 # define BLOCK_MASK	(~(BLOCK_SIZE-1))
+# define NR_MEMBLOCKS	(ED_MEMSIZE / BLOCK_SIZE)
 # define CAT		-1
 
 typedef struct {
@@ -82,6 +86,7 @@ typedef struct {
 
 # define BLOCK(lb, blk)	\
 	(block) ((lb)->wb->offset + (intptr_t) (blk) - (intptr_t) (lb)->wb->buf)
+# define TMPOFFSET(lb, offset)	((offset) - (long) (lb)->nmem * BLOCK_SIZE)
 
 # define EDFULLTREE	0x8000
 # define EDDEPTH	0x7fff
@@ -96,18 +101,22 @@ typedef struct {
  */
 linebuf *lb_new(linebuf *lb, char *filename)
 {
-    char buf[STRINGSZ];
     int i;
     btbuf *bt;
 
     if (lb != (linebuf *) NULL) {
-	/* refresh; close the old tmpfile */
+	/* refresh; close the old tmpfile and release memory blocks */
 	lb_inact(lb);
+	for (i = lb->nmem; i > 0; ) {
+	    FREE(lb->mem[--i]);
+	}
     } else {
 	/* allocate new line buffer */
 	lb = ALLOC(linebuf, 1);
 
 	lb->file = strcpy(ALLOC(char, strlen(filename) + 1), filename);
+	lb->fd = -1;
+	lb->mem = (char **) NULL;
 
 	bt = lb->bt;
 	for (i = NR_EDBUFS; i > 0; --i) {
@@ -129,13 +138,8 @@ linebuf *lb_new(linebuf *lb, char *filename)
     }
     lb->blksz = 0;
     lb->txtsz = 0;
-
-    /* create or truncate tmpfile */
-    lb->fd = P_open(path_native(buf, lb->file),
-		    O_CREAT | O_TRUNC | O_RDWR | O_BINARY, 0600);
-    if (lb->fd < 0) {
-	fatal("cannot create editor tmpfile \"%s\"", lb->file);
-    }
+    lb->nmem = 0;
+    lb->spill = FALSE;	/* tmpfile is created when needed */
 
     return lb;
 }
@@ -158,6 +162,12 @@ void lb_del(linebuf *lb)
     FREE(lb->file);
 
     /* release memory */
+    if (lb->mem != (char **) NULL) {
+	for (i = lb->nmem; i > 0; ) {
+	    FREE(lb->mem[--i]);
+	}
+	FREE(lb->mem);
+    }
     bt = lb->bt;
     for (i = NR_EDBUFS; i > 0; --i) {
 	FREE(bt->buf);
@@ -191,35 +201,55 @@ static void lb_act(linebuf *lb)
     char buf[STRINGSZ];
 
     if (lb->fd < 0) {
-	lb->fd = P_open(path_native(buf, lb->file), O_RDWR | O_BINARY, 0);
-	if (lb->fd < 0) {
-	    fatal("cannot reopen editor tmpfile \"%s\"", lb->file);
+	if (!lb->spill) {
+	    /* create or truncate tmpfile */
+	    lb->fd = P_open(path_native(buf, lb->file),
+			    O_CREAT | O_TRUNC | O_RDWR | O_BINARY, 0600);
+	    if (lb->fd < 0) {
+		fatal("cannot create editor tmpfile \"%s\"", lb->file);
+	    }
+	    lb->spill = TRUE;
+	} else {
+	    lb->fd = P_open(path_native(buf, lb->file), O_RDWR | O_BINARY, 0);
+	    if (lb->fd < 0) {
+		fatal("cannot reopen editor tmpfile \"%s\"", lb->file);
+	    }
 	}
     }
 }
 
 /*
  * NAME:	linebuf->write()
- * DESCRIPTION:	Write the output buffer to the tmpfile.
+ * DESCRIPTION:	Write the output buffer to memory, or to the tmpfile.
  */
 static void lb_write(linebuf *lb)
 {
     if (lb->blksz > 0) {
 	long offset;
 
+	offset = lb->wb->offset;
 # ifdef TMPFILE_SIZE
-	if (lb->wb->offset >= TMPFILE_SIZE - BLOCK_SIZE) {
+	if (offset >= TMPFILE_SIZE - BLOCK_SIZE) {
 	    error("Editor tmpfile too large");
 	}
 # endif
 
-	/* make the line buffer active */
-	lb_act(lb);
+	if (offset == (long) lb->nmem * BLOCK_SIZE && lb->nmem < NR_MEMBLOCKS) {
+	    /* keep in memory */
+	    if (lb->mem == (char **) NULL) {
+		lb->mem = ALLOC(char*, NR_MEMBLOCKS);
+	    }
+	    lb->mem[lb->nmem++] = (char *) memcpy(ALLOC(char, BLOCK_SIZE),
+						  lb->wb->buf, BLOCK_SIZE);
+	} else {
+	    /* make the line buffer active */
+	    lb_act(lb);
 
-	/* write in tmpfile */
-	P_lseek(lb->fd, offset = lb->wb->offset, SEEK_SET);	/* EOF */
-	if (P_write(lb->fd, lb->wb->buf, BLOCK_SIZE) < 0) {
-	    error("Failed to write editor tmpfile");
+	    /* write in tmpfile */
+	    P_lseek(lb->fd, TMPOFFSET(lb, offset), SEEK_SET);	/* EOF */
+	    if (P_write(lb->fd, lb->wb->buf, BLOCK_SIZE) < 0) {
+		error("Failed to write editor tmpfile");
+	    }
 	}
 	/* cycle buffers */
 	lb->wb = lb->wb->prev;
@@ -241,6 +271,12 @@ static blk *bk_load(linebuf *lb, block b)
     /* check the write buffer */
     bt = lb->wb;
     if (b < bt->offset || b >= bt->offset + lb->blksz) {
+	if (b < lb->nmem * BLOCK_SIZE) {
+	    /* kept in memory */
+	    return (blk *) ((lb->buf = lb->mem[b / BLOCK_SIZE]) +
+			    b % BLOCK_SIZE);
+	}
+
 	/*
 	 * walk through the read buffers to see if the block can be found
 	 */
@@ -252,7 +288,8 @@ static blk *bk_load(linebuf *lb, block b)
 		 */
 		lb_act(lb);
 		bt = bt->prev;
-		P_lseek(lb->fd, bt->offset = b - (b % BLOCK_SIZE), SEEK_SET);
+		bt->offset = b - (b % BLOCK_SIZE);
+		P_lseek(lb->fd, TMPOFFSET(lb, bt->offset), SEEK_SET);
 		if (P_read(lb->fd, bt->buf, BLOCK_SIZE) != BLOCK_SIZE) {
 		    fatal("cannot read editor tmpfile \"%s\"", lb->file);
 		}
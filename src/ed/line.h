@@ -37,6 +37,9 @@ typedef struct _btbuf_ {
 typedef struct {
     char *file;				/* tmpfile name */
     int fd;				/* tmpfile fd */
+    bool spill;				/* tmpfile created? */
+    char **mem;				/* blocks kept in memory */
+    Int nmem;				/* # blocks kept in memory */
     char *buf;				/* current low-level buffer */
     int blksz;				/* block size in write buffer */
     int txtsz;				/* text size in write buffer */
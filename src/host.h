@@ -248,6 +248,7 @@ extern void  P_message	(char*);
 # define P_read		read
 # define P_write	write
 # define P_lseek	lseek
+# define P_pread	pread
 # define P_fstat	fstat
 # define P_stat		stat
 # define P_access	access
@@ -267,6 +268,7 @@ extern int P_close	(int);
 extern int P_read	(int, char*, int);
 extern int P_write	(int, char*, int);
 extern off_t P_lseek	(int, off_t, int);
+extern int P_pread	(int, char*, int, off_t);
 extern int P_fstat	(int, struct stat*);
 extern int P_stat	(char*, struct stat*);
 extern int P_access	(char*, int);
@@ -282,6 +284,13 @@ extern int P_execv	(char*, char**);
 extern bool  P_opendir	(char*);
 extern char *P_readdir	(void);
 extern void  P_closedir	(void);
+extern void  P_prefetch	(char*);
+
+# define DW_ALL		-2		/* all watched directories changed */
+
+extern int   P_watchdir	(char*);
+extern void  P_unwatchdir	(int);
+extern int   P_dirchanged	(void);
 
 # ifndef voidf
 # define voidf		void
@@ -289,11 +298,19 @@ extern void  P_closedir	(void);
 
 extern voidf *P_dload	(char*, char*);
 
+# define HUGEPAGESZ	2097152		/* huge page size */
+# define PA_HUGE	0x01		/* back with huge pages if possible */
+# define PA_PREFAULT	0x02		/* fault in all pages immediately */
+
+extern char *P_palloc	(size_t, int, bool*);
+extern void  P_pfree	(char*, size_t);
+
 extern void  P_srandom	(long);
 extern long  P_random	(void);
 
 extern Uint  P_time	(void);
 extern Uint  P_mtime	(unsigned short*);
+extern Uuint P_utime	(void);
 extern char *P_ctime	(char*, Uint);
 
 /* these must be the same on all hosts */
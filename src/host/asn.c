@@ -1317,6 +1317,266 @@ static Uint asn_wordinv(Uint n)
     return n1;
 }
 
+# ifdef __SIZEOF_INT128__
+/*
+ * With 128 bit products available, modular exponentiation is done with
+ * 64 bit limbs.  ASIs are converted on entry and exit, since the rest of
+ * this file uses 32 bit limbs.
+ */
+typedef unsigned __int128 Udint;
+
+/*
+ * NAME:	asl->wordinv()
+ * DESCRIPTION:	compute an inverse modulo 2 ** 64 (for odd n)
+ */
+static Uuint asl_wordinv(Uuint n)
+{
+    Uuint n1;
+
+    n1 = n;			/* correct to 3 bits */
+    n1 *= 2 - n * n1;		/* 6 */
+    n1 *= 2 - n * n1;		/* 12 */
+    n1 *= 2 - n * n1;		/* 24 */
+    n1 *= 2 - n * n1;		/* 48 */
+    n1 *= 2 - n * n1;		/* 96 */
+
+    return n1;
+}
+
+/*
+ * NAME:	asl->mult()
+ * DESCRIPTION:	c = a * b, sizeof(c) = size << 1
+ */
+static void asl_mult(Uuint *c, Uuint *a, Uuint *b, Uint size)
+{
+    Uint i, j;
+    Uuint m, carry;
+    Udint p;
+
+    memset(c, '\0', (size << 1) * sizeof(Uuint));
+    for (i = 0; i < size; i++) {
+	m = a[i];
+	carry = 0;
+	for (j = 0; j < size; j++) {
+	    p = (Udint) m * b[j] + c[i + j] + carry;
+	    c[i + j] = (Uuint) p;
+	    carry = (Uuint) (p >> 64);
+	}
+	c[i + size] = carry;
+    }
+}
+
+/*
+ * NAME:	asl->sqr()
+ * DESCRIPTION:	c = a * a, sizeof(c) = size << 1
+ */
+static void asl_sqr(Uuint *c, Uuint *a, Uint size)
+{
+    Uint i, j;
+    Uuint m, carry, d;
+    Udint p;
+
+    /* cross products, each computed once */
+    memset(c, '\0', (size << 1) * sizeof(Uuint));
+    for (i = 0; i < size - 1; i++) {
+	m = a[i];
+	carry = 0;
+	for (j = i + 1; j < size; j++) {
+	    p = (Udint) m * a[j] + c[i + j] + carry;
+	    c[i + j] = (Uuint) p;
+	    carry = (Uuint) (p >> 64);
+	}
+	c[i + size] = carry;
+    }
+
+    /* double them */
+    carry = 0;
+    for (i = 0; i < size << 1; i++) {
+	d = c[i];
+	c[i] = (d << 1) | carry;
+	carry = d >> 63;
+    }
+
+    /* add squares */
+    carry = 0;
+    for (i = 0; i < size; i++) {
+	p = (Udint) a[i] * a[i] + c[i << 1] + carry;
+	c[i << 1] = (Uuint) p;
+	p = (Udint) c[(i << 1) + 1] + (Uuint) (p >> 64);
+	c[(i << 1) + 1] = (Uuint) p;
+	carry = (Uuint) (p >> 64);
+    }
+}
+
+/*
+ * NAME:	asl->monpro()
+ * DESCRIPTION:	compute the Montgomery product of a and b
+ *		sizeof(t) = size << 1
+ */
+static void asl_monpro(Uuint *c, Uuint *t, Uuint *a, Uuint *b, Uuint *n, Uint size, Uuint n0)
+{
+    Uint i, j;
+    Uuint m, carry, high;
+    Udint p;
+
+    if (a == b) {
+	asl_sqr(t, a, size);
+    } else {
+	asl_mult(t, a, b, size);
+    }
+
+    /* reduce */
+    high = 0;
+    for (i = 0; i < size; i++) {
+	m = t[i] * n0;
+	carry = 0;
+	for (j = 0; j < size; j++) {
+	    p = (Udint) m * n[j] + t[i + j] + carry;
+	    t[i + j] = (Uuint) p;
+	    carry = (Uuint) (p >> 64);
+	}
+	p = (Udint) t[i + size] + carry + high;
+	t[i + size] = (Uuint) p;
+	high = (Uuint) (p >> 64);
+    }
+    t += size;
+
+    if (high == 0) {
+	for (i = size; i > 0; ) {
+	    --i;
+	    if (t[i] != n[i]) {
+		break;
+	    }
+	}
+	if (t[i] < n[i]) {
+	    memcpy(c, t, size * sizeof(Uuint));
+	    return;
+	}
+    }
+    carry = 0;
+    for (i = 0; i < size; i++) {
+	m = t[i] - n[i] - carry;
+	carry = (t[i] < n[i] || (t[i] == n[i] && carry));
+	c[i] = m;
+    }
+}
+
+/*
+ * NAME:	asl->import()
+ * DESCRIPTION:	convert 32 bit limbs to 64 bit limbs
+ */
+static void asl_import(Uuint *c, Uint *a, Uint sizea, Uint size)
+{
+    Uint i;
+
+    memset(c, '\0', size * sizeof(Uuint));
+    for (i = 0; i < sizea; i++) {
+	c[i >> 1] |= (Uuint) a[i] << ((i & 1) << 5);
+    }
+}
+
+/*
+ * NAME:	asl->export()
+ * DESCRIPTION:	convert 64 bit limbs to 32 bit limbs
+ */
+static void asl_export(Uint *c, Uuint *a, Uint sizec)
+{
+    Uint i;
+
+    for (i = 0; i < sizec; i++) {
+	c[i] = (Uint) (a[i >> 1] >> ((i & 1) << 5));
+    }
+}
+
+
+/*
+ * NAME:	asn->powqmod()
+ * DESCRIPTION:	compute a ** b % mod (a > 1, b > 1, (mod & 1) != 0)
+ *		sizeof(t) = (sizemod + 1) << 1
+ */
+static void asn_powqmod(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint sizea, Uint sizeb, Uint sizemod)
+{
+    Uint size, nbits, i, j, window, wsize, *y;
+    Uuint n0, *n, *x, *tt, *tab;
+    bool first;
+
+    size = (sizemod + 1) >> 1;
+    nbits = sizeb << 5;
+    for (window = b[sizeb - 1]; !(window & 0x80000000L); window <<= 1) {
+	--nbits;
+    }
+    /* window size by exponent length, as in the HAC table */
+    wsize = (nbits > 671) ? 6 : (nbits > 239) ? 5 : (nbits > 79) ? 4 :
+	    (nbits > 23) ? 3 : 1;
+
+    /* allocate */
+    n = ALLOCA(Uuint, (size << 2) + (size << (wsize - 1)));
+    x = n + size;
+    tt = x + size;
+    tab = tt + (size << 1);
+    y = ALLOCA(Uint, (size << 1) + sizea + 1);
+
+    /* tab[0] = a * R % mod */
+    memset(y, '\0', (size << 1) * sizeof(Uint));
+    memcpy(y + (size << 1), a, sizea * sizeof(Uint));
+    asi_div(y, t, y, mod, (size << 1) + sizea, sizemod);
+    asl_import(tab, y, sizemod, size);
+    asl_import(n, mod, sizemod, size);
+    n0 = -asl_wordinv(n[0]);
+
+    /* tab[] = { odd powers of tab[0] } */
+    if (wsize > 1) {
+	asl_monpro(x, tt, tab, tab, n, size, n0);
+	for (i = 1; i < 1 << (wsize - 1); i++) {
+	    asl_monpro(tab + i * size, tt, tab + (i - 1) * size, x, n, size,
+		       n0);
+	}
+    }
+
+# define BIT(i)	((b[(i) >> 5] >> ((i) & 31)) & 1)
+    first = TRUE;
+    i = nbits;
+    while (i != 0) {
+	if (!BIT(i - 1)) {
+	    asl_monpro(x, tt, x, x, n, size, n0);
+	    --i;
+	    continue;
+	}
+
+	/* find the longest window that ends in a 1 bit */
+	j = (i > wsize) ? i - wsize : 0;
+	while (!BIT(j)) {
+	    j++;
+	}
+	for (window = 0; i > j; ) {
+	    window = (window << 1) | BIT(i - 1);
+	    --i;
+	    if (!first) {
+		asl_monpro(x, tt, x, x, n, size, n0);
+	    }
+	}
+
+	if (first) {
+	    memcpy(x, tab + (window >> 1) * size, size * sizeof(Uuint));
+	    first = FALSE;
+	} else {
+	    asl_monpro(x, tt, x, tab + (window >> 1) * size, n, size, n0);
+	}
+    }
+# undef BIT
+
+    /* c = x * (R ** -1) */
+    memset(tab, '\0', size * sizeof(Uuint));
+    tab[0] = 1;
+    asl_monpro(x, tt, x, tab, n, size, n0);
+    asl_export(c, x, sizemod);
+
+    AFREE(y);
+    AFREE(n);
+}
+
+# else
+
 /*
  * NAME:	asn->monpro()
  * DESCRIPTION:	compute the Montgomery product of a and b
@@ -1449,6 +1709,7 @@ static void asn_powqmod(Uint *c, Uint *t, Uint *a, Uint *b, Uint *mod, Uint size
     AFREE(y);
     AFREE(x);
 }
+# endif /* __SIZEOF_INT128__ */
 
 /*
  * NAME:	asn->pow2mod()
@@ -0,0 +1,149 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "dgd.h"
+# include <dirent.h>
+# ifdef LINUX
+# include <sys/inotify.h>
+# endif
+
+static DIR *d;
+
+/*
+ * NAME:	P->opendir()
+ * DESCRIPTION:	open a directory
+ */
+bool P_opendir(char *dir)
+{
+    d = opendir(dir);
+    return (d != (DIR *) NULL);
+}
+
+/*
+ * NAME:	P->readdir()
+ * DESCRIPTION:	read a directory, skipping . and ..
+ */
+char *P_readdir()
+{
+    struct dirent *de;
+
+    do {
+	de = readdir(d);
+	if (de == (struct dirent *) NULL) {
+	    return (char *) NULL;
+	}
+    } while (de->d_name[0] == '.' && (de->d_name[1] == '\0' ||
+	     (de->d_name[1] == '.' && de->d_name[2] == '\0')));
+    return de->d_name;
+}
+
+/*
+ * NAME:	P->closedir()
+ * DESCRIPTION:	close a directory
+ */
+void P_closedir()
+{
+    closedir(d);
+}
+
+# ifdef LINUX
+static int ifd = -1;		/* inotify descriptor */
+static union {
+    struct inotify_event event;
+    char buf[8192];
+} ibuf;				/* inotify event buffer */
+static int ibufsz, ibufp;	/* size of and position in event buffer */
+
+/*
+ * NAME:	P->watchdir()
+ * DESCRIPTION:	watch a directory for changes, return a watch descriptor
+ *		or -1
+ */
+int P_watchdir(char *dir)
+{
+    if (ifd < 0) {
+	ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (ifd < 0) {
+	    return -1;
+	}
+    }
+    return inotify_add_watch(ifd, dir,
+			     IN_ATTRIB | IN_CREATE | IN_DELETE |
+			     IN_DELETE_SELF | IN_MODIFY | IN_MOVE_SELF |
+			     IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR);
+}
+
+/*
+ * NAME:	P->unwatchdir()
+ * DESCRIPTION:	stop watching a directory
+ */
+void P_unwatchdir(int wd)
+{
+    inotify_rm_watch(ifd, wd);
+}
+
+/*
+ * NAME:	P->dirchanged()
+ * DESCRIPTION:	return the next changed directory, DW_ALL if any may have
+ *		changed, or -1 if none
+ */
+int P_dirchanged()
+{
+    struct inotify_event *event;
+
+    if (ibufp == ibufsz) {
+	if (ifd < 0 || (ibufsz = read(ifd, ibuf.buf, sizeof(ibuf))) <= 0) {
+	    ibufsz = ibufp = 0;
+	    return -1;
+	}
+	ibufp = 0;
+    }
+    event = (struct inotify_event *) (ibuf.buf + ibufp);
+    ibufp += sizeof(struct inotify_event) + event->len;
+    return (event->mask & IN_Q_OVERFLOW) ? DW_ALL : event->wd;
+}
+# else
+/*
+ * NAME:	P->watchdir()
+ * DESCRIPTION:	watch a directory for changes (not supported)
+ */
+int P_watchdir(char *dir)
+{
+    UNREFERENCED_PARAMETER(dir);
+    return -1;
+}
+
+/*
+ * NAME:	P->unwatchdir()
+ * DESCRIPTION:	stop watching a directory
+ */
+void P_unwatchdir(int wd)
+{
+    UNREFERENCED_PARAMETER(wd);
+}
+
+/*
+ * NAME:	P->dirchanged()
+ * DESCRIPTION:	return the next changed directory, or -1 if none
+ */
+int P_dirchanged()
+{
+    return -1;
+}
+# endif
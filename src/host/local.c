@@ -0,0 +1,154 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010-2011 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# define INCLUDE_FILE_IO
+# include "dgd.h"
+# include <signal.h>
+# include <sys/mman.h>
+
+# ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS	MAP_ANON
+# endif
+
+/*
+ * NAME:	term()
+ * DESCRIPTION:	catch SIGTERM
+ */
+static void term()
+{
+    signal(SIGTERM, term);
+    interrupt();
+}
+
+/*
+ * NAME:	main()
+ * DESCRIPTION:	main program
+ */
+int main(int argc, char *argv[])
+{
+    long seed;
+    unsigned short mtime;
+
+    seed = P_mtime(&mtime);
+    P_srandom(seed ^ ((long) mtime << 22));
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, term);
+    return dgd_main(argc, argv);
+}
+
+/*
+ * NAME:	P->message()
+ * DESCRIPTION:	show message
+ */
+void P_message(char *mess)
+{
+    fputs(mess, stderr);
+    fflush(stderr);
+}
+
+/*
+ * NAME:	P->palloc()
+ * DESCRIPTION:	allocate pages of memory from the system
+ */
+char *P_palloc(size_t size, int flags, bool *huge)
+{
+    char *mem, *p;
+    size_t sz;
+
+    *huge = FALSE;
+# ifdef MAP_HUGETLB
+    if (flags & PA_HUGE) {
+	/* try explicit huge pages first */
+	mem = (char *) mmap((void *) NULL, ALGN(size, HUGEPAGESZ),
+			    PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+# ifdef MAP_POPULATE
+			    ((flags & PA_PREFAULT) ? MAP_POPULATE : 0),
+# else
+			    0,
+# endif
+			    -1, 0);
+	if (mem != (char *) MAP_FAILED) {
+	    *huge = TRUE;
+	    return mem;
+	}
+    }
+# endif
+
+    /* map with room to align to a huge page boundary */
+    sz = (flags & PA_HUGE) ? size + HUGEPAGESZ : size;
+    mem = (char *) mmap((void *) NULL, sz, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == (char *) MAP_FAILED) {
+	return (char *) NULL;
+    }
+    if (flags & PA_HUGE) {
+	p = (char *) ALGN((uintptr_t) mem, HUGEPAGESZ);
+	if (p != mem) {
+	    munmap(mem, p - mem);
+	}
+	if (mem + sz != p + size) {
+	    munmap(p + size, mem + sz - (p + size));
+	}
+	mem = p;
+# ifdef MADV_HUGEPAGE
+	/* transparent huge pages */
+	*huge = (madvise(mem, size, MADV_HUGEPAGE) == 0);
+# endif
+    }
+
+    if (flags & PA_PREFAULT) {
+	/*
+	 * touch every page from this thread, which also places the memory
+	 * on the local NUMA node
+	 */
+	for (p = mem; p < mem + size; p += 4096) {
+	    *p = '\0';
+	}
+    }
+    return mem;
+}
+
+/*
+ * NAME:	P->pfree()
+ * DESCRIPTION:	return pages of memory to the system
+ */
+void P_pfree(char *mem, size_t size)
+{
+    munmap(mem, size);
+}
+
+/*
+ * NAME:	P->prefetch()
+ * DESCRIPTION:	have the system start reading a file in the background
+ */
+void P_prefetch(char *file)
+{
+# ifdef POSIX_FADV_WILLNEED
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd >= 0) {
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+    }
+# else
+    UNREFERENCED_PARAMETER(file);
+# endif
+}
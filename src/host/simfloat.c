@@ -20,6 +20,12 @@
 # define INCLUDE_CTYPE
 # include "dgd.h"
 # include "xfloat.h"
+# include <float.h>
+
+# if defined(__STDC_IEC_559__) && defined(FLT_EVAL_METHOD) && \
+     FLT_EVAL_METHOD == 0
+# define NATIVE_FLOAT		/* IEEE doubles without excess precision */
+# endif
 
 typedef struct {
     unsigned short sign;	/* 0: positive, 0x8000: negative */
@@ -895,6 +901,59 @@ void flt_ftoa(xfloat *f, char *buffer)
     }
 }
 
+# ifdef NATIVE_FLOAT
+/*
+ * An xfloat is the high 48 bits of an IEEE double.  Basic operations are
+ * first performed on native doubles.  The result is used only if it is
+ * far enough away from the rounding boundary of an xfloat that the 44 bit
+ * emulation is certain to round the same way; otherwise, or if the result
+ * is not a normal double, the emulation is used after all.
+ */
+# define N_NORMAL(f)	(((f)->high & 0x7ff0) != 0)
+# define N_GUARD	0x0800	/* 4 units in the last place of a flt */
+
+/*
+ * NAME:	n_xftod()
+ * DESCRIPTION:	convert an xfloat to a native double
+ */
+static double n_xftod(xfloat *f)
+{
+    Uuint bits;
+    double d;
+
+    bits = ((Uuint) f->high << 48) | ((Uuint) f->low << 16);
+    memcpy(&d, &bits, sizeof(double));
+    return d;
+}
+
+/*
+ * NAME:	n_dtoxf()
+ * DESCRIPTION:	convert a native double to an xfloat, rounding like
+ *		f_ftoxf().  Return FALSE if the emulation is needed
+ */
+static bool n_dtoxf(double d, xfloat *f)
+{
+    Uuint bits;
+    unsigned short exp, rest;
+
+    memcpy(&bits, &d, sizeof(double));
+    exp = (bits >> 52) & 0x7ff;
+    rest = (unsigned short) bits - (0x8000 - N_GUARD);
+    if (exp <= 1 || exp == 0x7ff || rest <= 2 * N_GUARD) {
+	/* too close to call */
+	return FALSE;
+    }
+
+    bits += 0x8000;
+    if (((bits >> 52) & 0x7ff) == 0x7ff) {
+	f_erange();
+    }
+    f->high = bits >> 48;
+    f->low = (Uint) (bits >> 16);
+    return TRUE;
+}
+# endif
+
 /*
  * NAME:	float->itof()
  * DESCRIPTION:	convert an integer to a float
@@ -928,6 +987,12 @@ void flt_add(xfloat *f1, xfloat *f2)
 {
     flt a, b;
 
+# ifdef NATIVE_FLOAT
+    if (N_NORMAL(f1) && N_NORMAL(f2) &&
+	n_dtoxf(n_xftod(f1) + n_xftod(f2), f1)) {
+	return;
+    }
+# endif
     f_xftof(f2, &b);
     f_xftof(f1, &a);
     f_add(&a, &b);
@@ -942,6 +1007,12 @@ void flt_sub(xfloat *f1, xfloat *f2)
 {
     flt a, b;
 
+# ifdef NATIVE_FLOAT
+    if (N_NORMAL(f1) && N_NORMAL(f2) &&
+	n_dtoxf(n_xftod(f1) - n_xftod(f2), f1)) {
+	return;
+    }
+# endif
     f_xftof(f2, &b);
     f_xftof(f1, &a);
     f_sub(&a, &b);
@@ -956,6 +1027,12 @@ void flt_mult(xfloat *f1, xfloat *f2)
 {
     flt a, b;
 
+# ifdef NATIVE_FLOAT
+    if (N_NORMAL(f1) && N_NORMAL(f2) &&
+	n_dtoxf(n_xftod(f1) * n_xftod(f2), f1)) {
+	return;
+    }
+# endif
     f_xftof(f1, &a);
     f_xftof(f2, &b);
     f_mult(&a, &b);
@@ -970,6 +1047,12 @@ void flt_div(xfloat *f1, xfloat *f2)
 {
     flt a, b;
 
+# ifdef NATIVE_FLOAT
+    if (N_NORMAL(f1) && N_NORMAL(f2) &&
+	n_dtoxf(n_xftod(f1) / n_xftod(f2), f1)) {
+	return;
+    }
+# endif
     f_xftof(f2, &b);
     f_xftof(f1, &a);
     f_div(&a, &b);
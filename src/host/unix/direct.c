@@ -58,3 +58,31 @@ void P_closedir()
 {
     closedir(d);
 }
+
+/*
+ * NAME:	P->watchdir()
+ * DESCRIPTION:	watch a directory for changes (not supported)
+ */
+int P_watchdir(char *dir)
+{
+    UNREFERENCED_PARAMETER(dir);
+    return -1;
+}
+
+/*
+ * NAME:	P->unwatchdir()
+ * DESCRIPTION:	stop watching a directory
+ */
+void P_unwatchdir(int wd)
+{
+    UNREFERENCED_PARAMETER(wd);
+}
+
+/*
+ * NAME:	P->dirchanged()
+ * DESCRIPTION:	return the next changed directory, or -1 if none
+ */
+int P_dirchanged()
+{
+    return -1;
+}
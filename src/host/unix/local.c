@@ -17,8 +17,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+# define INCLUDE_FILE_IO
 # include "dgd.h"
 # include <signal.h>
+# include <sys/mman.h>
+
+# ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS	MAP_ANON
+# endif
 
 /*
  * NAME:	term()
@@ -55,3 +61,94 @@ void P_message(char *mess)
     fputs(mess, stderr);
     fflush(stderr);
 }
+
+/*
+ * NAME:	P->palloc()
+ * DESCRIPTION:	allocate pages of memory from the system
+ */
+char *P_palloc(size_t size, int flags, bool *huge)
+{
+    char *mem, *p;
+    size_t sz;
+
+    *huge = FALSE;
+# ifdef MAP_HUGETLB
+    if (flags & PA_HUGE) {
+	/* try explicit huge pages first */
+	mem = (char *) mmap((void *) NULL, ALGN(size, HUGEPAGESZ),
+			    PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+# ifdef MAP_POPULATE
+			    ((flags & PA_PREFAULT) ? MAP_POPULATE : 0),
+# else
+			    0,
+# endif
+			    -1, 0);
+	if (mem != (char *) MAP_FAILED) {
+	    *huge = TRUE;
+	    return mem;
+	}
+    }
+# endif
+
+    /* map with room to align to a huge page boundary */
+    sz = (flags & PA_HUGE) ? size + HUGEPAGESZ : size;
+    mem = (char *) mmap((void *) NULL, sz, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == (char *) MAP_FAILED) {
+	return (char *) NULL;
+    }
+    if (flags & PA_HUGE) {
+	p = (char *) ALGN((uintptr_t) mem, HUGEPAGESZ);
+	if (p != mem) {
+	    munmap(mem, p - mem);
+	}
+	if (mem + sz != p + size) {
+	    munmap(p + size, mem + sz - (p + size));
+	}
+	mem = p;
+# ifdef MADV_HUGEPAGE
+	/* transparent huge pages */
+	*huge = (madvise(mem, size, MADV_HUGEPAGE) == 0);
+# endif
+    }
+
+    if (flags & PA_PREFAULT) {
+	/*
+	 * touch every page from this thread, which also places the memory
+	 * on the local NUMA node
+	 */
+	for (p = mem; p < mem + size; p += 4096) {
+	    *p = '\0';
+	}
+    }
+    return mem;
+}
+
+/*
+ * NAME:	P->pfree()
+ * DESCRIPTION:	return pages of memory to the system
+ */
+void P_pfree(char *mem, size_t size)
+{
+    munmap(mem, size);
+}
+
+/*
+ * NAME:	P->prefetch()
+ * DESCRIPTION:	have the system start reading a file in the background
+ */
+void P_prefetch(char *file)
+{
+# ifdef POSIX_FADV_WILLNEED
+    int fd;
+
+    fd = open(file, O_RDONLY);
+    if (fd >= 0) {
+	posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+    }
+# else
+    UNREFERENCED_PARAMETER(file);
+# endif
+}
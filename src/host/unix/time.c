@@ -43,6 +43,18 @@ Uint P_mtime(unsigned short *milli)
     return (Uint) time.tv_sec;
 }
 
+/*
+ * NAME:	P->utime()
+ * DESCRIPTION:	return the current time in microseconds
+ */
+Uuint P_utime()
+{
+    struct timeval time;
+
+    gettimeofday(&time, (struct timezone *) NULL);
+    return (Uuint) time.tv_sec * 1000000 + time.tv_usec;
+}
+
 /*
  * NAME:	P->ctime()
  * DESCRIPTION:	convert the given time to a string
@@ -122,6 +122,18 @@ long P_lseek(int fd, long offset, int whence)
     return _lseek(fd, offset, whence);
 }
 
+/*
+ * NAME:	P->pread()
+ * DESCRIPTION:	read from a file at a given offset
+ */
+int P_pread(int fd, char *buf, int nbytes, long offset)
+{
+    if (_lseek(fd, offset, SEEK_SET) < 0) {
+	return -1;
+    }
+    return _read(fd, buf, nbytes);
+}
+
 /*
  * NAME:	P->stat()
  * DESCRIPTION:	get information about a file
@@ -291,6 +303,34 @@ void P_closedir(void)
     }
 }
 
+/*
+ * NAME:	P->watchdir()
+ * DESCRIPTION:	watch a directory for changes (not supported)
+ */
+int P_watchdir(char *dir)
+{
+    UNREFERENCED_PARAMETER(dir);
+    return -1;
+}
+
+/*
+ * NAME:	P->unwatchdir()
+ * DESCRIPTION:	stop watching a directory
+ */
+void P_unwatchdir(int wd)
+{
+    UNREFERENCED_PARAMETER(wd);
+}
+
+/*
+ * NAME:	P->dirchanged()
+ * DESCRIPTION:	return the next changed directory, or -1 if none
+ */
+int P_dirchanged(void)
+{
+    return -1;
+}
+
 /*
  * NAME:	P->execv()
  * DESCRIPTION:	execute a program
@@ -302,3 +342,13 @@ int P_execv(char *path, char **argv)
     P_message("Hotbooting not supported on Windows\012");	/* LF */
     return -1;
 }
+
+/*
+ * NAME:	P->prefetch()
+ * DESCRIPTION:	have the system start reading a file in the background
+ *		(not supported)
+ */
+void P_prefetch(char *file)
+{
+    UNREFERENCED_PARAMETER(file);
+}
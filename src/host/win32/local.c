@@ -17,6 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+# include <windows.h>
 # include "dgd.h"
 
 /*
@@ -36,3 +37,32 @@ long P_random(void)
 {
     return (long) (rand() ^ (rand() << 9) ^ (rand() << 16));
 }
+
+/*
+ * NAME:	P->palloc()
+ * DESCRIPTION:	allocate pages of memory from the system
+ */
+char *P_palloc(size_t size, int flags, bool *huge)
+{
+    char *mem, *p;
+
+    *huge = FALSE;
+    mem = (char *) VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE,
+				PAGE_READWRITE);
+    if (mem != (char *) NULL && (flags & PA_PREFAULT)) {
+	for (p = mem; p < mem + size; p += 4096) {
+	    *p = '\0';
+	}
+    }
+    return mem;
+}
+
+/*
+ * NAME:	P->pfree()
+ * DESCRIPTION:	return pages of memory to the system
+ */
+void P_pfree(char *mem, size_t size)
+{
+    UNREFERENCED_PARAMETER(size);
+    VirtualFree(mem, 0, MEM_RELEASE);
+}
@@ -56,6 +56,20 @@ Uint P_mtime(unsigned short *milli)
     return (Uint) (time / 10000000);
 }
 
+/*
+ * NAME:	P->utime()
+ * DESCRIPTION:	return the time in microseconds since Jan 1, 1970
+ */
+Uuint P_utime(void)
+{
+    FILETIME ft;
+    __int64 time;
+
+    GetSystemTimeAsFileTime(&ft);
+    time = ((__int64) ft.dwHighDateTime << 32) + ft.dwLowDateTime - UNIXBIRTH;
+    return (Uuint) (time / 10);
+}
+
 /*
  * NAME:	P->ctime()
  * DESCRIPTION:	return time as string
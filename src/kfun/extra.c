@@ -21,6 +21,7 @@
 # define INCLUDE_CTYPE
 # include "kfun.h"
 # include "parse.h"
+# include "rgx.h"
 # include "asn.h"
 # endif
 
@@ -134,6 +135,33 @@ FUNCDEF("explode", kf_explode, pt_explode, 0)
 char pt_explode[] = { C_TYPECHECKED | C_STATIC, 2, 0, 0, 8,
 		      T_STRING | (1 << REFSHIFT), T_STRING, T_STRING };
 
+/*
+ * NAME:	substr->find()
+ * DESCRIPTION:	find the first occurrence of s that lies entirely before end,
+ *		or return NULL
+ */
+static char *substr_find(char *p, char *end, char *s, unsigned int slen)
+{
+    char *q;
+
+    if (end - p < (long) slen) {
+	return (char *) NULL;
+    }
+    if (slen == 1) {
+	return (char *) memchr(p, *s, end - p);
+    }
+
+    /* find the first character with memchr, then compare the rest */
+    end -= slen - 1;
+    while ((q=(char *) memchr(p, *s, end - p)) != (char *) NULL) {
+	if (memcmp(q + 1, s + 1, slen - 1) == 0) {
+	    return q;
+	}
+	p = q + 1;
+    }
+    return (char *) NULL;
+}
+
 /*
  * NAME:	kfun->explode()
  * DESCRIPTION:	explode a string
@@ -141,7 +169,7 @@ char pt_explode[] = { C_TYPECHECKED | C_STATIC, 2, 0, 0, 8,
 int kf_explode(frame *f)
 {
     unsigned int len, slen, size;
-    char *p, *s;
+    char *p, *q, *s, *end;
     value *v;
     array *a;
 
@@ -166,60 +194,37 @@ int kf_explode(frame *f)
 	}
     } else {
 	/*
-	 * split up the string with the separator
+	 * split up the string with the separator.  A separator at the start
+	 * or at the end of the string does not produce an empty element.
 	 */
-	size = 1;
+	end = p + len;
 	if (len >= slen && memcmp(p, s, slen) == 0) {
 	    /* skip leading separator */
 	    p += slen;
-	    len -= slen;
 	}
-	while (len > slen) {
-	    if (memcmp(p, s, slen) == 0) {
-		/* separator found */
-		p += slen;
-		len -= slen;
-		size++;
-	    } else {
-		/* next char */
-		p++;
-		--len;
-	    }
+
+	/* count the separators that don't end the string */
+	size = 1;
+	for (q = p;
+	     (q=substr_find(q, end - 1, s, slen)) != (char *) NULL;
+	     q += slen) {
+	    size++;
 	}
 
 	a = arr_new(f->data, (long) size);
 	v = a->elts;
-
-	p = f->sp[1].u.string->text;
-	len = f->sp[1].u.string->len;
-	size = 0;
-	if (len > slen && memcmp(p, s, slen) == 0) {
-	    /* skip leading separator */
-	    p += slen;
-	    len -= slen;
-	}
-	while (len > slen) {
-	    if (memcmp(p, s, slen) == 0) {
-		/* separator found */
-		PUT_STRVAL(v, str_new(p - size, (long) size));
-		v++;
-		p += slen;
-		len -= slen;
-		size = 0;
-	    } else {
-		/* next char */
-		p++;
-		--len;
-		size++;
-	    }
+	while ((q=substr_find(p, end - 1, s, slen)) != (char *) NULL) {
+	    /* separator found */
+	    PUT_STRVAL(v, str_new(p, (long) (q - p)));
+	    v++;
+	    p = q + slen;
 	}
-	if (len != slen || memcmp(p, s, slen) != 0) {
-	    /* remainder isn't a sepatator */
-	    size += len;
-	    p += len;
+	if (end - p >= slen && memcmp(end - slen, s, slen) == 0) {
+	    /* remainder ends in a separator */
+	    end -= slen;
 	}
 	/* final array element */
-	PUT_STRVAL(v, str_new(p - size, (long) size));
+	PUT_STRVAL(v, str_new(p, (long) (end - p)));
     }
 
     str_del((f->sp++)->u.string);
@@ -292,6 +297,507 @@ int kf_implode(frame *f)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("find_string", kf_find_string, pt_find_string, 0)
+# else
+char pt_find_string[] = { C_TYPECHECKED | C_STATIC, 2, 1, 0, 9, T_INT,
+			  T_STRING, T_STRING, T_INT };
+
+/*
+ * NAME:	kfun->find_string()
+ * DESCRIPTION:	find the index of a substring in a string, searching from
+ *		an optional offset, or return -1
+ */
+int kf_find_string(frame *f, int nargs)
+{
+    Int offset;
+    char *p, *q, *end;
+    string *sub;
+
+    offset = (nargs > 2) ? (f->sp++)->u.number : 0;
+    sub = f->sp->u.string;
+    p = f->sp[1].u.string->text;
+    end = p + f->sp[1].u.string->len;
+    if (offset < 0 || offset > end - p) {
+	error("Index out of range");
+    }
+    i_add_ticks(f, (end - p - offset) >> 3);
+
+    if (sub->len == 0) {
+	q = p + offset;
+    } else {
+	q = substr_find(p + offset, end, sub->text, sub->len);
+    }
+
+    str_del((f->sp++)->u.string);
+    str_del(f->sp->u.string);
+    PUT_INTVAL(f->sp, (q != (char *) NULL) ? q - p : -1);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("find_strings", kf_find_strings, pt_find_strings, 0)
+# else
+char pt_find_strings[] = { C_TYPECHECKED | C_STATIC, 2, 0, 0, 8,
+			   T_INT | (1 << REFSHIFT), T_STRING, T_STRING };
+
+/*
+ * NAME:	kfun->find_strings()
+ * DESCRIPTION:	find the indices of all non-overlapping occurrences of a
+ *		substring in a string
+ */
+int kf_find_strings(frame *f)
+{
+    char *p, *q, *s, *end;
+    unsigned int slen, size;
+    value *v;
+    array *a;
+
+    s = f->sp->u.string->text;
+    slen = f->sp->u.string->len;
+    p = f->sp[1].u.string->text;
+    end = p + f->sp[1].u.string->len;
+
+    /* count occurrences */
+    size = 0;
+    if (slen != 0) {
+	for (q = p;
+	     (q=substr_find(q, end, s, slen)) != (char *) NULL;
+	     q += slen) {
+	    size++;
+	}
+    }
+
+    a = arr_new(f->data, (long) size);
+    for (v = a->elts, q = p; size != 0; v++, q += slen, --size) {
+	q = substr_find(q, end, s, slen);
+	PUT_INTVAL(v, q - p);
+    }
+
+    str_del((f->sp++)->u.string);
+    i_add_ticks(f, ((end - p) >> 3) + a->size);
+    str_del(f->sp->u.string);
+    PUT_ARRVAL(f->sp, a);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("replace_string", kf_replace_string, pt_replace_string, 0)
+# else
+char pt_replace_string[] = { C_TYPECHECKED | C_STATIC, 3, 0, 0, 9, T_STRING,
+			     T_STRING, T_STRING, T_STRING };
+
+/*
+ * NAME:	kfun->replace_string()
+ * DESCRIPTION:	replace all non-overlapping occurrences of a substring
+ */
+int kf_replace_string(frame *f)
+{
+    char *p, *q, *r, *s, *end;
+    unsigned int slen, rlen, count;
+    string *str;
+
+    r = f->sp->u.string->text;
+    rlen = f->sp->u.string->len;
+    s = f->sp[1].u.string->text;
+    slen = f->sp[1].u.string->len;
+    str = f->sp[2].u.string;
+    p = str->text;
+    end = p + str->len;
+
+    /* count occurrences */
+    count = 0;
+    if (slen != 0) {
+	for (q = p;
+	     (q=substr_find(q, end, s, slen)) != (char *) NULL;
+	     q += slen) {
+	    count++;
+	}
+    }
+    i_add_ticks(f, (end - p) >> 3);
+
+    if (count != 0) {
+	/* build the result in one go */
+	str = str_new((char *) NULL,
+		      (long) str->len +
+		      (long) count * ((long) rlen - (long) slen));
+	i_add_ticks(f, str->len >> 3);
+	q = str->text;
+	do {
+	    s = substr_find(p, end, f->sp[1].u.string->text, slen);
+	    memcpy(q, p, s - p);
+	    q += s - p;
+	    memcpy(q, r, rlen);
+	    q += rlen;
+	    p = s + slen;
+	} while (--count != 0);
+	memcpy(q, p, end - p);
+
+	str_del(f->sp[2].u.string);
+	PUT_STR(&f->sp[2], str);
+    }
+
+    str_del((f->sp++)->u.string);
+    str_del((f->sp++)->u.string);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("regexp_match", kf_regexp_match, pt_regexp_match, 0)
+# else
+char pt_regexp_match[] = { C_TYPECHECKED | C_STATIC, 2, 0, 0, 8, T_INT,
+			   T_STRING, T_STRING };
+
+# define RGXCACHESZ	128	/* # entries in regexp cache */
+
+typedef struct {
+    string *pattern;		/* regular expression */
+    rgx *rx;			/* compiled regular expression */
+} rgxentry;
+
+static rgxentry rgxcache[RGXCACHESZ];	/* compiled regular expressions */
+
+/*
+ * NAME:	regexp->compile()
+ * DESCRIPTION:	fetch a compiled regular expression from the cache,
+ *		compiling it if needed
+ */
+static rgx *regexp_compile(string *str)
+{
+    rgxentry *c;
+    rgx *rx;
+
+    c = &rgxcache[((uintptr_t) str / sizeof(string)) % RGXCACHESZ];
+    if (c->pattern == str) {
+	return c->rx;
+    }
+    rx = rgx_new(str->text, str->len);
+    if (c->pattern != (string *) NULL) {
+	str_del(c->pattern);
+	rgx_del(c->rx);
+    }
+    str_ref(c->pattern = str);
+    return c->rx = rx;
+}
+
+/*
+ * NAME:	kfun->purge_regexp()
+ * DESCRIPTION:	empty the regexp cache, before dynamic memory is purged
+ */
+void kf_purge_regexp()
+{
+    int i;
+    rgxentry *c;
+
+    for (i = RGXCACHESZ, c = rgxcache; i > 0; --i, c++) {
+	if (c->pattern != (string *) NULL) {
+	    str_del(c->pattern);
+	    rgx_del(c->rx);
+	    c->pattern = (string *) NULL;
+	}
+    }
+}
+
+/*
+ * NAME:	regexp->search()
+ * DESCRIPTION:	search for the next match, checking the ticks spent so far
+ */
+static bool regexp_search(frame *f, rgx *rx, string *str, ssizet start,
+			  Int *sub, Uint *ticks, Int *buffer)
+{
+    if (!f->rlim->noticks && f->rlim->ticks <= *ticks) {
+	if (buffer != (Int *) NULL) {
+	    FREE(buffer);
+	}
+	f->rlim->ticks = 0;
+	error("Out of ticks");
+    }
+    return rgx_search(rx, str->text, str->len, start, FALSE, sub, ticks);
+}
+
+/*
+ * NAME:	kfun->regexp_match()
+ * DESCRIPTION:	check if a regular expression matches the whole string
+ */
+int kf_regexp_match(frame *f)
+{
+    rgx *rx;
+    bool match;
+    Uint ticks;
+
+    rx = regexp_compile(f->sp->u.string);
+    ticks = 0;
+    match = rgx_search(rx, f->sp[1].u.string->text, f->sp[1].u.string->len,
+		       0, TRUE, (Int *) NULL, &ticks);
+    i_add_ticks(f, ticks);
+
+    str_del((f->sp++)->u.string);
+    str_del(f->sp->u.string);
+    PUT_INTVAL(f->sp, match);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("regexp_search", kf_regexp_search, pt_regexp_search, 0)
+# else
+char pt_regexp_search[] = { C_TYPECHECKED | C_STATIC, 2, 1, 0, 9,
+			    T_INT | (1 << REFSHIFT), T_STRING, T_STRING,
+			    T_INT };
+
+/*
+ * NAME:	kfun->regexp_search()
+ * DESCRIPTION:	search for a regular expression from an optional offset,
+ *		returning ({ start, end }) of the match followed by the
+ *		same for each subexpression, or nil
+ */
+int kf_regexp_search(frame *f, int nargs)
+{
+    Int offset;
+    rgx *rx;
+    string *str;
+    Uint ticks;
+    Int sub[RGX_NSUB << 1];
+    unsigned short i, n;
+    array *a;
+    value *v;
+
+    offset = (nargs > 2) ? (f->sp++)->u.number : 0;
+    str = f->sp[1].u.string;
+    if (offset < 0 || offset > str->len) {
+	error("Index out of range");
+    }
+    rx = regexp_compile(f->sp->u.string);
+
+    ticks = 0;
+    if (regexp_search(f, rx, str, (ssizet) offset, sub, &ticks, (Int *) NULL))
+    {
+	n = rgx_nsub(rx) << 1;
+	a = arr_new(f->data, (long) n);
+	for (i = 0, v = a->elts; i < n; i += 2) {
+	    /* inclusive ranges */
+	    PUT_INTVAL(v, sub[i]);
+	    v++;
+	    PUT_INTVAL(v, (sub[i] >= 0) ? sub[i + 1] - 1 : -1);
+	    v++;
+	}
+    } else {
+	a = (array *) NULL;
+    }
+    i_add_ticks(f, ticks);
+
+    str_del((f->sp++)->u.string);
+    str_del(f->sp->u.string);
+    if (a != (array *) NULL) {
+	PUT_ARRVAL(f->sp, a);
+    } else {
+	*f->sp = nil_value;
+    }
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("regexp_split", kf_regexp_split, pt_regexp_split, 0)
+# else
+char pt_regexp_split[] = { C_TYPECHECKED | C_STATIC, 2, 0, 0, 8,
+			   T_STRING | (1 << REFSHIFT), T_STRING, T_STRING };
+
+/*
+ * NAME:	kfun->regexp_split()
+ * DESCRIPTION:	split a string on the non-empty matches of a regular
+ *		expression
+ */
+int kf_regexp_split(frame *f)
+{
+    rgx *rx;
+    string *str;
+    Uint ticks, size, n;
+    Int sub[RGX_NSUB << 1];
+    Int *match;
+    ssizet pos;
+    array *a;
+    value *v;
+
+    rx = regexp_compile(f->sp->u.string);
+    str = f->sp[1].u.string;
+
+    /* collect matches */
+    ticks = 0;
+    size = 16;
+    match = ALLOC(Int, size);
+    n = 0;
+    for (pos = 0;
+	 pos <= str->len && regexp_search(f, rx, str, pos, sub, &ticks, match);
+	 ) {
+	if (sub[1] == sub[0]) {
+	    pos = sub[0] + 1;	/* skip empty match */
+	    continue;
+	}
+	if ((n >> 1) + 2 > conf_array_size()) {
+	    FREE(match);
+	    error("Array too large");
+	}
+	if (n == size) {
+	    match = REALLOC(match, Int, size, size << 1);
+	    size <<= 1;
+	}
+	match[n++] = sub[0];
+	match[n++] = sub[1];
+	pos = sub[1];
+    }
+
+    a = arr_new(f->data, (long) n / 2 + 1);
+    v = a->elts;
+    for (pos = 0, size = 0; size < n; size += 2) {
+	PUT_STRVAL(v, str_new(str->text + pos, (long) match[size] - pos));
+	v++;
+	pos = match[size + 1];
+    }
+    PUT_STRVAL(v, str_new(str->text + pos, (long) str->len - pos));
+    FREE(match);
+    i_add_ticks(f, ticks + a->size);
+
+    str_del((f->sp++)->u.string);
+    str_del(f->sp->u.string);
+    PUT_ARRVAL(f->sp, a);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("regexp_replace", kf_regexp_replace, pt_regexp_replace, 0)
+# else
+char pt_regexp_replace[] = { C_TYPECHECKED | C_STATIC, 3, 0, 0, 9, T_STRING,
+			     T_STRING, T_STRING, T_STRING };
+
+/*
+ * NAME:	regexp->subst()
+ * DESCRIPTION:	expand a replacement for a match: & is the match, \1 to \9
+ *		are subexpressions, and \ quotes the next character; return
+ *		the length of the expansion
+ */
+static long regexp_subst(char *buf, string *rep, char *text, Int *sub,
+			 unsigned short nsub)
+{
+    char *p, *end;
+    long len;
+    int n;
+
+    len = 0;
+    for (p = rep->text, end = p + rep->len; p < end; p++) {
+	if (*p == '&') {
+	    n = 0;
+	} else if (*p == '\\' && p + 1 < end) {
+	    p++;
+	    if (*p < '1' || *p > '9') {
+		if (buf != (char *) NULL) {
+		    buf[len] = *p;
+		}
+		len++;
+		continue;
+	    }
+	    n = *p - '0';
+	} else {
+	    if (buf != (char *) NULL) {
+		buf[len] = *p;
+	    }
+	    len++;
+	    continue;
+	}
+
+	if (n < nsub && sub[n << 1] >= 0) {
+	    if (buf != (char *) NULL) {
+		memcpy(buf + len, text + sub[n << 1],
+		       sub[(n << 1) + 1] - sub[n << 1]);
+	    }
+	    len += sub[(n << 1) + 1] - sub[n << 1];
+	}
+    }
+
+    return len;
+}
+
+/*
+ * NAME:	kfun->regexp_replace()
+ * DESCRIPTION:	replace all matches of a regular expression
+ */
+int kf_regexp_replace(frame *f)
+{
+    rgx *rx;
+    string *str, *rep;
+    Uint ticks, size, n;
+    unsigned short nsub;
+    Int *match;
+    ssizet pos;
+    long len;
+    char *p;
+
+    rep = f->sp->u.string;
+    rx = regexp_compile(f->sp[1].u.string);
+    str = f->sp[2].u.string;
+    nsub = rgx_nsub(rx);
+
+    /* collect matches */
+    ticks = 0;
+    size = 16 * (nsub << 1);
+    match = ALLOC(Int, size);
+    n = 0;
+    len = str->len;
+    for (pos = 0; pos <= str->len; ) {
+	if (n == size) {
+	    match = REALLOC(match, Int, size, size << 1);
+	    size <<= 1;
+	}
+	if (!regexp_search(f, rx, str, pos, match + n, &ticks, match)) {
+	    break;
+	}
+	len += regexp_subst((char *) NULL, rep, str->text, match + n, nsub) -
+	       (match[n + 1] - match[n]);
+	pos = (match[n + 1] != match[n]) ? match[n + 1] : match[n] + 1;
+	n += nsub << 1;
+    }
+
+    if (n != 0) {
+	/* build the result in one go */
+	if (len > MAX_STRLEN) {
+	    FREE(match);
+	    error("String too long");
+	}
+	rep = str_new((char *) NULL, len);
+	p = rep->text;
+	pos = 0;
+	for (size = 0; size < n; size += nsub << 1) {
+	    memcpy(p, str->text + pos, match[size] - pos);
+	    p += match[size] - pos;
+	    p += regexp_subst(p, f->sp->u.string, str->text, match + size,
+			      nsub);
+	    pos = match[size + 1];
+	}
+	memcpy(p, str->text + pos, str->len - pos);
+	ticks += len >> 3;
+
+	str_del(f->sp[2].u.string);
+	PUT_STR(&f->sp[2], rep);
+    }
+    FREE(match);
+    i_add_ticks(f, ticks);
+
+    str_del((f->sp++)->u.string);
+    str_del((f->sp++)->u.string);
+    return 0;
+}
+# endif
+
 # ifdef FUNCDEF
 FUNCDEF("random", kf_random, pt_random, 0)
 # else
@@ -316,56 +822,196 @@ FUNCDEF("sscanf", kf_sscanf, pt_sscanf, 0)
 char pt_sscanf[] = { C_STATIC | C_ELLIPSIS, 2, 1, 0, 9, T_INT, T_STRING,
 		     T_STRING, T_LVALUE };
 
+# define SC_MATCH	0	/* match literal text */
+# define SC_STRING	1	/* %s up to literal text */
+# define SC_STREND	2	/* %s up to the end of the string */
+# define SC_STRINT	3	/* %s followed by %d */
+# define SC_STRFLT	4	/* %s followed by %f */
+# define SC_INT		5	/* %d */
+# define SC_FLOAT	6	/* %f */
+# define SC_CHAR	7	/* %c */
+# define SC_ERROR	8	/* bad format string */
+
+typedef struct {
+    char type;			/* operation */
+    bool skip;			/* %*: no assignment */
+    ssizet len;			/* length of literal text */
+    char *text;			/* literal text */
+} scanop;
+
+typedef struct {
+    char *format;		/* format text */
+    unsigned int flen;		/* length of format text */
+    unsigned short nops;	/* # operations */
+    scanop *ops;		/* operations */
+} scanfmt;
+
+# define SCANCACHESZ	1024	/* # entries in format cache */
+
+static scanfmt *scancache[SCANCACHESZ];	/* compiled formats, static mem */
+
 /*
- * NAME:	match
- * DESCRIPTION:	match a string possibly including %%, up to the next %[sdfc] or
- *		the end of the string
+ * NAME:	scan->literal()
+ * DESCRIPTION:	copy literal text up to the next conversion, replacing %% by %
  */
-static bool match(char *f, char *s, unsigned int *flenp, unsigned int *slenp)
+static unsigned int scan_literal(char **formatp, unsigned int *flenp,
+				 char *text)
 {
-    char *p;
-    unsigned int flen, slen;
+    char *format, *p;
+    unsigned int flen;
 
+    format = *formatp;
     flen = *flenp;
-    slen = *slenp;
+    p = text;
+    while (flen > 0 && (format[0] != '%' || format[1] == '%')) {
+	if (format[0] == '%') {
+	    format++;
+	    --flen;
+	}
+	*p++ = *format++;
+	--flen;
+    }
+
+    *formatp = format;
+    *flenp = flen;
+    return p - text;
+}
+
+/*
+ * NAME:	scan->compile()
+ * DESCRIPTION:	compile a sscanf format string into a list of operations,
+ *		in static memory
+ */
+static scanfmt *scan_compile(string *str)
+{
+    scanfmt *fmt;
+    scanop *op;
+    char *format, *text;
+    unsigned int flen;
+
+    /*
+     * a literal is always followed by a conversion, so there are at most
+     * 2 operations for every 3 characters, apart from a final error
+     */
+    format = str->text;
+    flen = str->len;
+    m_static();
+    fmt = (scanfmt *) ALLOC(char, sizeof(scanfmt) +
+				  ((flen << 1) / 3 + 2) * sizeof(scanop) +
+				  (flen << 1));
+    m_dynamic();
+    fmt->flen = flen;
+    fmt->ops = op = (scanop *) (fmt + 1);
+    fmt->format = (char *) (op + (flen << 1) / 3 + 2);
+    memcpy(fmt->format, format, flen);
+    text = fmt->format + flen;
 
     while (flen > 0) {
-	/* look for first % */
-	p = (char *) memchr(f, '%', flen);
-
-	if (p == (char *) NULL) {
-	    /* no remaining % */
-	    if (memcmp(f, s, flen) == 0) {
-		*slenp -= slen - flen;
-		return TRUE;
-	    } else {
-		return FALSE;	/* no match */
+	if (format[0] != '%' || format[1] == '%') {
+	    /* initial part */
+	    op->text = text;
+	    op->len = scan_literal(&format, &flen, text);
+	    if (flen == 0) {
+		break;	/* nothing to assign after this */
 	    }
+	    text += op->len;
+	    op->type = SC_MATCH;
+	    op->skip = FALSE;
+	    op++;
+	}
+
+	/* skip first % */
+	format++;
+	--flen;
+
+	/*
+	 * check for %*
+	 */
+	if (flen != 0 && *format == '*') {
+	    /* no assignment */
+	    format++;
+	    --flen;
+	    op->skip = TRUE;
+	} else {
+	    op->skip = FALSE;
+	}
+
+	if (flen == 0) {
+	    op++->type = SC_ERROR;
+	    break;
 	}
+	--flen;
+	switch (*format++) {
+	case 's':
+	    if (format[0] == '%' && format[1] != '%') {
+		switch ((format[1] == '*') ? format[2] : format[1]) {
+		case 'd':
+		    op->type = SC_STRINT;
+		    break;
 
-	if (p[1] == '%') {
-	    /* %% */
-	    if (memcmp(f, s, ++p - f) == 0) {
-		/* matched up to and including the first % */
-		s += p - f;
-		slen -= p - f;
-		flen -= ++p - f;
-		f = p;
+		case 'f':
+		    op->type = SC_STRFLT;
+		    break;
+
+		default:
+		    op->type = SC_ERROR;
+		    break;
+		}
+	    } else if (flen == 0) {
+		op->type = SC_STREND;
 	    } else {
-		return FALSE;	/* no match */
+		/* %s followed by non-%, includes the literal text */
+		op->type = SC_STRING;
+		op->text = text;
+		op->len = scan_literal(&format, &flen, text);
+		text += op->len;
 	    }
-	} else if (memcmp(f, s, p - f) == 0) {
-	    /* matched up to the first % */
-	    *flenp -= flen - (p - f);
-	    *slenp -= slen - (p - f);
-	    return TRUE;
-	} else {
-	    return FALSE;	/* no match */
+	    break;
+
+	case 'd':
+	    op->type = SC_INT;
+	    break;
+
+	case 'f':
+	    op->type = SC_FLOAT;
+	    break;
+
+	case 'c':
+	    op->type = SC_CHAR;
+	    break;
+
+	default:
+	    op->type = SC_ERROR;
+	    break;
+	}
+	if (op++->type == SC_ERROR) {
+	    break;
 	}
     }
 
-    *slenp -= slen;
-    return TRUE;
+    fmt->nops = op - fmt->ops;
+    return fmt;
+}
+
+/*
+ * NAME:	scan->format()
+ * DESCRIPTION:	get a compiled format string from the cache, or compile it.
+ *		Formats are looked up by contents and kept in static memory,
+ *		so the cache survives the end of the thread
+ */
+static scanfmt *scan_format(string *str)
+{
+    scanfmt **c;
+
+    c = &scancache[hashmem(str->text, str->len) % SCANCACHESZ];
+    if (*c != (scanfmt *) NULL) {
+	if ((*c)->flen == str->len &&
+	    memcmp((*c)->format, str->text, str->len) == 0) {
+	    return *c;
+	}
+	FREE(*c);
+    }
+    return *c = scan_compile(str);
 }
 
 /*
@@ -374,15 +1020,16 @@ static bool match(char *f, char *s, unsigned int *flenp, unsigned int *slenp)
  */
 int kf_sscanf(frame *f, int nargs)
 {
-    unsigned int flen, slen, size;
-    char *format, *x;
-    unsigned int fl, sl;
+    unsigned int slen, size, sl;
+    char *x;
     int matches;
     char *s;
     Int i;
     xfloat flt;
-    bool skip;
     value *top, *v;
+    scanfmt *fmt;
+    scanop *op;
+    unsigned short n;
 
     size = 0;
     x = NULL;
@@ -403,150 +1050,90 @@ int kf_sscanf(frame *f, int nargs)
     if (top[0].type != T_STRING) {
 	return 2;
     }
-    format = top[0].u.string->text;
-    flen = top[0].u.string->len;
+    fmt = scan_format(top[0].u.string);
 
     i_add_ticks(f, 8 * nargs);
     matches = 0;
 
-    while (flen > 0) {
-	if (format[0] != '%' || format[1] == '%') {
+    for (op = fmt->ops, n = fmt->nops; n != 0; op++, --n) {
+	switch (op->type) {
+	case SC_MATCH:
 	    /* match initial part */
-	    fl = flen;
-	    sl = slen;
-	    if (!match(format, s, &fl, &sl) || fl == flen) {
+	    if (op->len > slen || memcmp(s, op->text, op->len) != 0) {
 		goto no_match;
 	    }
-	    format += fl;
-	    flen -= fl;
-	    s += sl;
-	    slen -= sl;
-	}
-
-	/* skip first % */
-	format++;
-	--flen;
-
-	/*
-	 * check for %*
-	 */
-	if (*format == '*') {
-	    /* no assignment */
-	    format++;
-	    --flen;
-	    skip = TRUE;
-	} else {
-	    skip = FALSE;
-	}
-
-	--flen;
-	switch (*format++) {
-	case 's':
-	    /* %s */
-	    if (format[0] == '%' && format[1] != '%') {
-		switch ((format[1] == '*') ? format[2] : format[1]) {
-		case 'd':
-		    /*
-		     * %s%d
-		     */
-		    size = slen;
-		    x = s;
-		    while (!isdigit(*x)) {
-			if (slen == 0) {
-			    goto no_match;
-			}
-			if (x[0] == '-' && isdigit(x[1])) {
-			    break;
-			}
-			x++;
-			--slen;
-		    }
-		    size -= slen;
-		    break;
-
-		case 'f':
-		    /*
-		     * %s%f
-		     */
-		    size = slen;
-		    x = s;
-		    while (!isdigit(*x)) {
-			if (slen == 0) {
-			    goto no_match;
-			}
-			if ((x[0] == '-' || x[0] == '.') && isdigit(x[1])) {
-			    break;
-			}
-			x++;
-			--slen;
-		    }
-		    size -= slen;
+	    s += op->len;
+	    slen -= op->len;
+	    continue;
+
+	case SC_STRINT:
+	    /*
+	     * %s%d
+	     */
+	    size = slen;
+	    x = s;
+	    while (!isdigit(*x)) {
+		if (slen == 0) {
+		    goto no_match;
+		}
+		if (x[0] == '-' && isdigit(x[1])) {
 		    break;
+		}
+		x++;
+		--slen;
+	    }
+	    size -= slen;
+	    break;
 
-		default:
-		    error("Bad sscanf format string");
+	case SC_STRFLT:
+	    /*
+	     * %s%f
+	     */
+	    size = slen;
+	    x = s;
+	    while (!isdigit(*x)) {
+		if (slen == 0) {
+		    goto no_match;
 		}
-	    } else {
-		/*
-		 * %s followed by non-%
-		 */
-		if (flen == 0) {
-		    /* match whole string */
-		    size = slen;
-		    x = s + slen;
-		    slen = 0;
-		} else {
-		    /* get # of chars to match after string */
-		    for (x = format, size = 0; x - format != flen;
-			 x++, size++) {
-			x = (char *) memchr(x, '%', flen - (x - format));
-			if (x == (char *) NULL) {
-			    x = format + flen;
-			    break;
-			} else if (x[1] != '%') {
-			    break;
-			}
-		    }
-		    size = (x - format) - size;
-
-		    x = s;
-		    for (;;) {
-			sl = slen - (x - s);
-			if (sl < size) {
-			    goto no_match;
-			}
-			x = (char *) memchr(x, format[0], sl - size + 1);
-			if (x == (char *) NULL) {
-			    goto no_match;
-			}
-			fl = flen;
-			if (match(format, x, &fl, &sl)) {
-			    format += fl;
-			    flen -= fl;
-			    size = x - s;
-			    x += sl;
-			    slen -= size + sl;
-			    break;
-			}
-			x++;
-		    }
+		if ((x[0] == '-' || x[0] == '.') && isdigit(x[1])) {
+		    break;
 		}
+		x++;
+		--slen;
 	    }
+	    size -= slen;
+	    break;
 
-	    if (!skip) {
-		if (nargs == 0) {
-		    error("No lvalue for %%s");
+	case SC_STREND:
+	    /* match whole string */
+	    size = slen;
+	    x = s + slen;
+	    slen = 0;
+	    break;
+
+	case SC_STRING:
+	    /* match up to the literal text that follows */
+	    x = s;
+	    for (;;) {
+		sl = slen - (x - s);
+		if (sl < op->len) {
+		    goto no_match;
 		}
-		--nargs;
-		PUSH_STRVAL(f, str_new(s, (long) size));
-		v = f->sp;
-		i_store(f);
-		v->u.string->ref--;
+		x = (char *) memchr(x, op->text[0], sl - op->len + 1);
+		if (x == (char *) NULL) {
+		    goto no_match;
+		}
+		if (memcmp(x, op->text, op->len) == 0) {
+		    size = x - s;
+		    x += op->len;
+		    slen -= size + op->len;
+		    break;
+		}
+		x++;
 	    }
-	    s = x;
 	    break;
 
-	case 'd':
+	case SC_INT:
 	    /* %d */
 	    x = s;
 	    while (slen != 0 && *x == ' ') {
@@ -560,7 +1147,7 @@ int kf_sscanf(frame *f, int nargs)
 	    }
 	    slen -= (s - x);
 
-	    if (!skip) {
+	    if (!op->skip) {
 		if (nargs == 0) {
 		    error("No lvalue for %%d");
 		}
@@ -568,9 +1155,10 @@ int kf_sscanf(frame *f, int nargs)
 		PUSH_INTVAL(f, i);
 		i_store(f);
 	    }
-	    break;
+	    matches++;
+	    continue;
 
-	case 'f':
+	case SC_FLOAT:
 	    /* %f */
 	    x = s;
 	    while (slen != 0 && *x == ' ') {
@@ -583,7 +1171,7 @@ int kf_sscanf(frame *f, int nargs)
 	    }
 	    slen -= (s - x);
 
-	    if (!skip) {
+	    if (!op->skip) {
 		if (nargs == 0) {
 		    error("No lvalue for %%f");
 		}
@@ -591,14 +1179,15 @@ int kf_sscanf(frame *f, int nargs)
 		PUSH_FLTVAL(f, flt);
 		i_store(f);
 	    }
-	    break;
+	    matches++;
+	    continue;
 
-	case 'c':
+	case SC_CHAR:
 	    /* %c */
 	    if (slen == 0) {
 		goto no_match;
 	    }
-	    if (!skip) {
+	    if (!op->skip) {
 		if (nargs == 0) {
 		    error("No lvalue for %%c");
 		}
@@ -608,11 +1197,25 @@ int kf_sscanf(frame *f, int nargs)
 	    }
 	    s++;
 	    --slen;
-	    break;
+	    matches++;
+	    continue;
 
 	default:
 	    error("Bad sscanf format string");
 	}
+
+	/* %s */
+	if (!op->skip) {
+	    if (nargs == 0) {
+		error("No lvalue for %%s");
+	    }
+	    --nargs;
+	    PUSH_STRVAL(f, str_new(s, (long) size));
+	    v = f->sp;
+	    i_store(f);
+	    v->u.string->ref--;
+	}
+	s = x;
 	matches++;
     }
 
@@ -669,12 +1272,127 @@ int kf_parse_string(frame *f, int nargs)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("build_grammar", kf_build_grammar, pt_build_grammar, 0)
+# else
+char pt_build_grammar[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
+			    T_INT | (1 << REFSHIFT), T_STRING };
+
+/*
+ * NAME:	kfun->build_grammar()
+ * DESCRIPTION:	fully construct the automata for a grammar in advance,
+ *		returning ({ DFA states, DFA size, SRP states, SRP size,
+ *		microseconds })
+ */
+int kf_build_grammar(frame *f)
+{
+    array *a;
+
+    if (OBJR(f->oindex)->flags & O_SPECIAL) {
+	error("build_grammar() from special purpose object");
+    }
+
+    a = ps_build_grammar(f, f->sp->u.string);
+    str_del(f->sp->u.string);
+    PUT_ARRVAL(f->sp, a);
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("hash_crc16", kf_hash_crc16, pt_hash_crc16, 0)
 # else
 char pt_hash_crc16[] = { C_TYPECHECKED | C_STATIC | C_ELLIPSIS, 1, 1, 0, 8,
 			 T_INT, T_STRING, T_STRING };
 
+static unsigned short crc16tab[] = {
+    0x0000, 0x2110, 0x4220, 0x6330, 0x8440, 0xa550, 0xc660, 0xe770,
+    0x0881, 0x2991, 0x4aa1, 0x6bb1, 0x8cc1, 0xadd1, 0xcee1, 0xeff1,
+    0x3112, 0x1002, 0x7332, 0x5222, 0xb552, 0x9442, 0xf772, 0xd662,
+    0x3993, 0x1883, 0x7bb3, 0x5aa3, 0xbdd3, 0x9cc3, 0xfff3, 0xdee3,
+    0x6224, 0x4334, 0x2004, 0x0114, 0xe664, 0xc774, 0xa444, 0x8554,
+    0x6aa5, 0x4bb5, 0x2885, 0x0995, 0xeee5, 0xcff5, 0xacc5, 0x8dd5,
+    0x5336, 0x7226, 0x1116, 0x3006, 0xd776, 0xf666, 0x9556, 0xb446,
+    0x5bb7, 0x7aa7, 0x1997, 0x3887, 0xdff7, 0xfee7, 0x9dd7, 0xbcc7,
+    0xc448, 0xe558, 0x8668, 0xa778, 0x4008, 0x6118, 0x0228, 0x2338,
+    0xccc9, 0xedd9, 0x8ee9, 0xaff9, 0x4889, 0x6999, 0x0aa9, 0x2bb9,
+    0xf55a, 0xd44a, 0xb77a, 0x966a, 0x711a, 0x500a, 0x333a, 0x122a,
+    0xfddb, 0xdccb, 0xbffb, 0x9eeb, 0x799b, 0x588b, 0x3bbb, 0x1aab,
+    0xa66c, 0x877c, 0xe44c, 0xc55c, 0x222c, 0x033c, 0x600c, 0x411c,
+    0xaeed, 0x8ffd, 0xeccd, 0xcddd, 0x2aad, 0x0bbd, 0x688d, 0x499d,
+    0x977e, 0xb66e, 0xd55e, 0xf44e, 0x133e, 0x322e, 0x511e, 0x700e,
+    0x9fff, 0xbeef, 0xdddf, 0xfccf, 0x1bbf, 0x3aaf, 0x599f, 0x788f,
+    0x8891, 0xa981, 0xcab1, 0xeba1, 0x0cd1, 0x2dc1, 0x4ef1, 0x6fe1,
+    0x8010, 0xa100, 0xc230, 0xe320, 0x0450, 0x2540, 0x4670, 0x6760,
+    0xb983, 0x9893, 0xfba3, 0xdab3, 0x3dc3, 0x1cd3, 0x7fe3, 0x5ef3,
+    0xb102, 0x9012, 0xf322, 0xd232, 0x3542, 0x1452, 0x7762, 0x5672,
+    0xeab5, 0xcba5, 0xa895, 0x8985, 0x6ef5, 0x4fe5, 0x2cd5, 0x0dc5,
+    0xe234, 0xc324, 0xa014, 0x8104, 0x6674, 0x4764, 0x2454, 0x0544,
+    0xdba7, 0xfab7, 0x9987, 0xb897, 0x5fe7, 0x7ef7, 0x1dc7, 0x3cd7,
+    0xd326, 0xf236, 0x9106, 0xb016, 0x5766, 0x7676, 0x1546, 0x3456,
+    0x4cd9, 0x6dc9, 0x0ef9, 0x2fe9, 0xc899, 0xe989, 0x8ab9, 0xaba9,
+    0x4458, 0x6548, 0x0678, 0x2768, 0xc018, 0xe108, 0x8238, 0xa328,
+    0x7dcb, 0x5cdb, 0x3feb, 0x1efb, 0xf98b, 0xd89b, 0xbbab, 0x9abb,
+    0x754a, 0x545a, 0x376a, 0x167a, 0xf10a, 0xd01a, 0xb32a, 0x923a,
+    0x2efd, 0x0fed, 0x6cdd, 0x4dcd, 0xaabd, 0x8bad, 0xe89d, 0xc98d,
+    0x267c, 0x076c, 0x645c, 0x454c, 0xa23c, 0x832c, 0xe01c, 0xc10c,
+    0x1fef, 0x3eff, 0x5dcf, 0x7cdf, 0x9baf, 0xbabf, 0xd98f, 0xf89f,
+    0x176e, 0x367e, 0x554e, 0x745e, 0x932e, 0xb23e, 0xd10e, 0xf01e
+};
+
+static unsigned short crc16slice[7][256];	/* tables for 8 bytes at a time */
+static bool crc16init;				/* tables initialized? */
+
+/*
+ * NAME:	hash->crc16_init()
+ * DESCRIPTION:	initialize the tables for 8 bytes at a time.  crc16slice[n]
+ *		is the effect of a byte followed by n + 1 zero bytes
+ */
+static void hash_crc16_init()
+{
+    int i, j;
+    unsigned short crc;
+
+    for (i = 0; i < 256; i++) {
+	crc = crc16tab[i];
+	for (j = 0; j < 7; j++) {
+	    crc16slice[j][i] = crc = (crc >> 8) ^ crc16tab[crc & 0xff];
+	}
+    }
+    crc16init = TRUE;
+}
+
+/*
+ * NAME:	hash->crc16()
+ * DESCRIPTION:	add a block of data to a 16 bit CRC (byte-swapped)
+ */
+static unsigned short hash_crc16(unsigned short crc, char *p, ssizet len)
+{
+    if (len >= 16) {
+	if (!crc16init) {
+	    hash_crc16_init();
+	}
+
+	/* slicing-by-8 */
+	do {
+	    crc ^= UCHAR(p[0]) | (UCHAR(p[1]) << 8);
+	    crc = crc16slice[6][crc & 0xff] ^ crc16slice[5][crc >> 8] ^
+		  crc16slice[4][UCHAR(p[2])] ^ crc16slice[3][UCHAR(p[3])] ^
+		  crc16slice[2][UCHAR(p[4])] ^ crc16slice[1][UCHAR(p[5])] ^
+		  crc16slice[0][UCHAR(p[6])] ^ crc16tab[UCHAR(p[7])];
+	    p += 8;
+	    len -= 8;
+	} while (len >= 8);
+    }
+
+    while (len != 0) {
+	crc = (crc >> 8) ^ crc16tab[UCHAR(crc ^ *p++)];
+	--len;
+    }
+    return crc;
+}
+
 /*
  * NAME:	kfun->hash_crc16()
  * DESCRIPTION:	Compute a 16 bit cyclic redundancy code for a string.
@@ -692,44 +1410,8 @@ char pt_hash_crc16[] = { C_TYPECHECKED | C_STATIC | C_ELLIPSIS, 1, 1, 0, 8,
  */
 int kf_hash_crc16(frame *f, int nargs)
 {
-    static unsigned short crctab[] = {
-	0x0000, 0x2110, 0x4220, 0x6330, 0x8440, 0xa550, 0xc660, 0xe770,
-	0x0881, 0x2991, 0x4aa1, 0x6bb1, 0x8cc1, 0xadd1, 0xcee1, 0xeff1,
-	0x3112, 0x1002, 0x7332, 0x5222, 0xb552, 0x9442, 0xf772, 0xd662,
-	0x3993, 0x1883, 0x7bb3, 0x5aa3, 0xbdd3, 0x9cc3, 0xfff3, 0xdee3,
-	0x6224, 0x4334, 0x2004, 0x0114, 0xe664, 0xc774, 0xa444, 0x8554,
-	0x6aa5, 0x4bb5, 0x2885, 0x0995, 0xeee5, 0xcff5, 0xacc5, 0x8dd5,
-	0x5336, 0x7226, 0x1116, 0x3006, 0xd776, 0xf666, 0x9556, 0xb446,
-	0x5bb7, 0x7aa7, 0x1997, 0x3887, 0xdff7, 0xfee7, 0x9dd7, 0xbcc7,
-	0xc448, 0xe558, 0x8668, 0xa778, 0x4008, 0x6118, 0x0228, 0x2338,
-	0xccc9, 0xedd9, 0x8ee9, 0xaff9, 0x4889, 0x6999, 0x0aa9, 0x2bb9,
-	0xf55a, 0xd44a, 0xb77a, 0x966a, 0x711a, 0x500a, 0x333a, 0x122a,
-	0xfddb, 0xdccb, 0xbffb, 0x9eeb, 0x799b, 0x588b, 0x3bbb, 0x1aab,
-	0xa66c, 0x877c, 0xe44c, 0xc55c, 0x222c, 0x033c, 0x600c, 0x411c,
-	0xaeed, 0x8ffd, 0xeccd, 0xcddd, 0x2aad, 0x0bbd, 0x688d, 0x499d,
-	0x977e, 0xb66e, 0xd55e, 0xf44e, 0x133e, 0x322e, 0x511e, 0x700e,
-	0x9fff, 0xbeef, 0xdddf, 0xfccf, 0x1bbf, 0x3aaf, 0x599f, 0x788f,
-	0x8891, 0xa981, 0xcab1, 0xeba1, 0x0cd1, 0x2dc1, 0x4ef1, 0x6fe1,
-	0x8010, 0xa100, 0xc230, 0xe320, 0x0450, 0x2540, 0x4670, 0x6760,
-	0xb983, 0x9893, 0xfba3, 0xdab3, 0x3dc3, 0x1cd3, 0x7fe3, 0x5ef3,
-	0xb102, 0x9012, 0xf322, 0xd232, 0x3542, 0x1452, 0x7762, 0x5672,
-	0xeab5, 0xcba5, 0xa895, 0x8985, 0x6ef5, 0x4fe5, 0x2cd5, 0x0dc5,
-	0xe234, 0xc324, 0xa014, 0x8104, 0x6674, 0x4764, 0x2454, 0x0544,
-	0xdba7, 0xfab7, 0x9987, 0xb897, 0x5fe7, 0x7ef7, 0x1dc7, 0x3cd7,
-	0xd326, 0xf236, 0x9106, 0xb016, 0x5766, 0x7676, 0x1546, 0x3456,
-	0x4cd9, 0x6dc9, 0x0ef9, 0x2fe9, 0xc899, 0xe989, 0x8ab9, 0xaba9,
-	0x4458, 0x6548, 0x0678, 0x2768, 0xc018, 0xe108, 0x8238, 0xa328,
-	0x7dcb, 0x5cdb, 0x3feb, 0x1efb, 0xf98b, 0xd89b, 0xbbab, 0x9abb,
-	0x754a, 0x545a, 0x376a, 0x167a, 0xf10a, 0xd01a, 0xb32a, 0x923a,
-	0x2efd, 0x0fed, 0x6cdd, 0x4dcd, 0xaabd, 0x8bad, 0xe89d, 0xc98d,
-	0x267c, 0x076c, 0x645c, 0x454c, 0xa23c, 0x832c, 0xe01c, 0xc10c,
-	0x1fef, 0x3eff, 0x5dcf, 0x7cdf, 0x9baf, 0xbabf, 0xd98f, 0xf89f,
-	0x176e, 0x367e, 0x554e, 0x745e, 0x932e, 0xb23e, 0xd10e, 0xf01e
-    };
     unsigned short crc;
     int i;
-    ssizet len;
-    char *p;
     Int cost;
 
     cost = 0;
@@ -745,10 +1427,8 @@ int kf_hash_crc16(frame *f, int nargs)
 
     crc = 0xffff;
     for (i = nargs; --i >= 0; ) {
-	p = f->sp[i].u.string->text;
-	for (len = f->sp[i].u.string->len; len != 0; --len) {
-	    crc = (crc >> 8) ^ crctab[UCHAR(crc ^ *p++)];
-	}
+	crc = hash_crc16(crc, f->sp[i].u.string->text,
+			 f->sp[i].u.string->len);
 	str_del(f->sp[i].u.string);
     }
     crc = (crc >> 8) + (crc << 8);
@@ -766,6 +1446,114 @@ FUNCDEF("hash_crc32", kf_hash_crc32, pt_hash_crc32, 0)
 char pt_hash_crc32[] = { C_TYPECHECKED | C_STATIC | C_ELLIPSIS, 1, 1, 0, 8,
 			 T_INT, T_STRING, T_STRING };
 
+static Uint crc32tab[] = {
+    0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L,
+    0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0x0edb8832L, 0x79dcb8a4L,
+    0xe0d5e91eL, 0x97d2d988L, 0x09b64c2bL, 0x7eb17cbdL, 0xe7b82d07L,
+    0x90bf1d91L, 0x1db71064L, 0x6ab020f2L, 0xf3b97148L, 0x84be41deL,
+    0x1adad47dL, 0x6ddde4ebL, 0xf4d4b551L, 0x83d385c7L, 0x136c9856L,
+    0x646ba8c0L, 0xfd62f97aL, 0x8a65c9ecL, 0x14015c4fL, 0x63066cd9L,
+    0xfa0f3d63L, 0x8d080df5L, 0x3b6e20c8L, 0x4c69105eL, 0xd56041e4L,
+    0xa2677172L, 0x3c03e4d1L, 0x4b04d447L, 0xd20d85fdL, 0xa50ab56bL,
+    0x35b5a8faL, 0x42b2986cL, 0xdbbbc9d6L, 0xacbcf940L, 0x32d86ce3L,
+    0x45df5c75L, 0xdcd60dcfL, 0xabd13d59L, 0x26d930acL, 0x51de003aL,
+    0xc8d75180L, 0xbfd06116L, 0x21b4f4b5L, 0x56b3c423L, 0xcfba9599L,
+    0xb8bda50fL, 0x2802b89eL, 0x5f058808L, 0xc60cd9b2L, 0xb10be924L,
+    0x2f6f7c87L, 0x58684c11L, 0xc1611dabL, 0xb6662d3dL, 0x76dc4190L,
+    0x01db7106L, 0x98d220bcL, 0xefd5102aL, 0x71b18589L, 0x06b6b51fL,
+    0x9fbfe4a5L, 0xe8b8d433L, 0x7807c9a2L, 0x0f00f934L, 0x9609a88eL,
+    0xe10e9818L, 0x7f6a0dbbL, 0x086d3d2dL, 0x91646c97L, 0xe6635c01L,
+    0x6b6b51f4L, 0x1c6c6162L, 0x856530d8L, 0xf262004eL, 0x6c0695edL,
+    0x1b01a57bL, 0x8208f4c1L, 0xf50fc457L, 0x65b0d9c6L, 0x12b7e950L,
+    0x8bbeb8eaL, 0xfcb9887cL, 0x62dd1ddfL, 0x15da2d49L, 0x8cd37cf3L,
+    0xfbd44c65L, 0x4db26158L, 0x3ab551ceL, 0xa3bc0074L, 0xd4bb30e2L,
+    0x4adfa541L, 0x3dd895d7L, 0xa4d1c46dL, 0xd3d6f4fbL, 0x4369e96aL,
+    0x346ed9fcL, 0xad678846L, 0xda60b8d0L, 0x44042d73L, 0x33031de5L,
+    0xaa0a4c5fL, 0xdd0d7cc9L, 0x5005713cL, 0x270241aaL, 0xbe0b1010L,
+    0xc90c2086L, 0x5768b525L, 0x206f85b3L, 0xb966d409L, 0xce61e49fL,
+    0x5edef90eL, 0x29d9c998L, 0xb0d09822L, 0xc7d7a8b4L, 0x59b33d17L,
+    0x2eb40d81L, 0xb7bd5c3bL, 0xc0ba6cadL, 0xedb88320L, 0x9abfb3b6L,
+    0x03b6e20cL, 0x74b1d29aL, 0xead54739L, 0x9dd277afL, 0x04db2615L,
+    0x73dc1683L, 0xe3630b12L, 0x94643b84L, 0x0d6d6a3eL, 0x7a6a5aa8L,
+    0xe40ecf0bL, 0x9309ff9dL, 0x0a00ae27L, 0x7d079eb1L, 0xf00f9344L,
+    0x8708a3d2L, 0x1e01f268L, 0x6906c2feL, 0xf762575dL, 0x806567cbL,
+    0x196c3671L, 0x6e6b06e7L, 0xfed41b76L, 0x89d32be0L, 0x10da7a5aL,
+    0x67dd4accL, 0xf9b9df6fL, 0x8ebeeff9L, 0x17b7be43L, 0x60b08ed5L,
+    0xd6d6a3e8L, 0xa1d1937eL, 0x38d8c2c4L, 0x4fdff252L, 0xd1bb67f1L,
+    0xa6bc5767L, 0x3fb506ddL, 0x48b2364bL, 0xd80d2bdaL, 0xaf0a1b4cL,
+    0x36034af6L, 0x41047a60L, 0xdf60efc3L, 0xa867df55L, 0x316e8eefL,
+    0x4669be79L, 0xcb61b38cL, 0xbc66831aL, 0x256fd2a0L, 0x5268e236L,
+    0xcc0c7795L, 0xbb0b4703L, 0x220216b9L, 0x5505262fL, 0xc5ba3bbeL,
+    0xb2bd0b28L, 0x2bb45a92L, 0x5cb36a04L, 0xc2d7ffa7L, 0xb5d0cf31L,
+    0x2cd99e8bL, 0x5bdeae1dL, 0x9b64c2b0L, 0xec63f226L, 0x756aa39cL,
+    0x026d930aL, 0x9c0906a9L, 0xeb0e363fL, 0x72076785L, 0x05005713L,
+    0x95bf4a82L, 0xe2b87a14L, 0x7bb12baeL, 0x0cb61b38L, 0x92d28e9bL,
+    0xe5d5be0dL, 0x7cdcefb7L, 0x0bdbdf21L, 0x86d3d2d4L, 0xf1d4e242L,
+    0x68ddb3f8L, 0x1fda836eL, 0x81be16cdL, 0xf6b9265bL, 0x6fb077e1L,
+    0x18b74777L, 0x88085ae6L, 0xff0f6a70L, 0x66063bcaL, 0x11010b5cL,
+    0x8f659effL, 0xf862ae69L, 0x616bffd3L, 0x166ccf45L, 0xa00ae278L,
+    0xd70dd2eeL, 0x4e048354L, 0x3903b3c2L, 0xa7672661L, 0xd06016f7L,
+    0x4969474dL, 0x3e6e77dbL, 0xaed16a4aL, 0xd9d65adcL, 0x40df0b66L,
+    0x37d83bf0L, 0xa9bcae53L, 0xdebb9ec5L, 0x47b2cf7fL, 0x30b5ffe9L,
+    0xbdbdf21cL, 0xcabac28aL, 0x53b39330L, 0x24b4a3a6L, 0xbad03605L,
+    0xcdd70693L, 0x54de5729L, 0x23d967bfL, 0xb3667a2eL, 0xc4614ab8L,
+    0x5d681b02L, 0x2a6f2b94L, 0xb40bbe37L, 0xc30c8ea1L, 0x5a05df1bL,
+    0x2d02ef8dL
+};
+
+static Uint crc32slice[7][256];		/* tables for 8 bytes at a time */
+static bool crc32init;				/* tables initialized? */
+
+/*
+ * NAME:	hash->crc32_init()
+ * DESCRIPTION:	initialize the tables for 8 bytes at a time.  crc32slice[n]
+ *		is the effect of a byte followed by n + 1 zero bytes
+ */
+static void hash_crc32_init()
+{
+    int i, j;
+    Uint crc;
+
+    for (i = 0; i < 256; i++) {
+	crc = crc32tab[i];
+	for (j = 0; j < 7; j++) {
+	    crc32slice[j][i] = crc = (crc >> 8) ^ crc32tab[crc & 0xff];
+	}
+    }
+    crc32init = TRUE;
+}
+
+/*
+ * NAME:	hash->crc32()
+ * DESCRIPTION:	add a block of data to a 32 bit CRC
+ */
+static Uint hash_crc32(Uint crc, char *p, ssizet len)
+{
+    if (len >= 16) {
+	if (!crc32init) {
+	    hash_crc32_init();
+	}
+
+	/* slicing-by-8 */
+	do {
+	    crc ^= UCHAR(p[0]) | (UCHAR(p[1]) << 8) | (UCHAR(p[2]) << 16) |
+		   ((Uint) UCHAR(p[3]) << 24);
+	    crc = crc32slice[6][crc & 0xff] ^ crc32slice[5][(crc >> 8) & 0xff] ^
+		  crc32slice[4][(crc >> 16) & 0xff] ^ crc32slice[3][crc >> 24] ^
+		  crc32slice[2][UCHAR(p[4])] ^ crc32slice[1][UCHAR(p[5])] ^
+		  crc32slice[0][UCHAR(p[6])] ^ crc32tab[UCHAR(p[7])];
+	    p += 8;
+	    len -= 8;
+	} while (len >= 8);
+    }
+
+    while (len != 0) {
+	crc = (crc >> 8) ^ crc32tab[UCHAR(crc ^ *p++)];
+	--len;
+    }
+    return crc;
+}
+
 /*
  * NAME:	kfun->hash_crc32()
  * DESCRIPTION:	Compute a 32 bit cyclic redundancy code for a string.
@@ -783,64 +1571,8 @@ char pt_hash_crc32[] = { C_TYPECHECKED | C_STATIC | C_ELLIPSIS, 1, 1, 0, 8,
  */
 int kf_hash_crc32(frame *f, int nargs)
 {
-    static Uint crctab[] = {
-	0x00000000L, 0x77073096L, 0xee0e612cL, 0x990951baL, 0x076dc419L,
-	0x706af48fL, 0xe963a535L, 0x9e6495a3L, 0x0edb8832L, 0x79dcb8a4L,
-	0xe0d5e91eL, 0x97d2d988L, 0x09b64c2bL, 0x7eb17cbdL, 0xe7b82d07L,
-	0x90bf1d91L, 0x1db71064L, 0x6ab020f2L, 0xf3b97148L, 0x84be41deL,
-	0x1adad47dL, 0x6ddde4ebL, 0xf4d4b551L, 0x83d385c7L, 0x136c9856L,
-	0x646ba8c0L, 0xfd62f97aL, 0x8a65c9ecL, 0x14015c4fL, 0x63066cd9L,
-	0xfa0f3d63L, 0x8d080df5L, 0x3b6e20c8L, 0x4c69105eL, 0xd56041e4L,
-	0xa2677172L, 0x3c03e4d1L, 0x4b04d447L, 0xd20d85fdL, 0xa50ab56bL,
-	0x35b5a8faL, 0x42b2986cL, 0xdbbbc9d6L, 0xacbcf940L, 0x32d86ce3L,
-	0x45df5c75L, 0xdcd60dcfL, 0xabd13d59L, 0x26d930acL, 0x51de003aL,
-	0xc8d75180L, 0xbfd06116L, 0x21b4f4b5L, 0x56b3c423L, 0xcfba9599L,
-	0xb8bda50fL, 0x2802b89eL, 0x5f058808L, 0xc60cd9b2L, 0xb10be924L,
-	0x2f6f7c87L, 0x58684c11L, 0xc1611dabL, 0xb6662d3dL, 0x76dc4190L,
-	0x01db7106L, 0x98d220bcL, 0xefd5102aL, 0x71b18589L, 0x06b6b51fL,
-	0x9fbfe4a5L, 0xe8b8d433L, 0x7807c9a2L, 0x0f00f934L, 0x9609a88eL,
-	0xe10e9818L, 0x7f6a0dbbL, 0x086d3d2dL, 0x91646c97L, 0xe6635c01L,
-	0x6b6b51f4L, 0x1c6c6162L, 0x856530d8L, 0xf262004eL, 0x6c0695edL,
-	0x1b01a57bL, 0x8208f4c1L, 0xf50fc457L, 0x65b0d9c6L, 0x12b7e950L,
-	0x8bbeb8eaL, 0xfcb9887cL, 0x62dd1ddfL, 0x15da2d49L, 0x8cd37cf3L,
-	0xfbd44c65L, 0x4db26158L, 0x3ab551ceL, 0xa3bc0074L, 0xd4bb30e2L,
-	0x4adfa541L, 0x3dd895d7L, 0xa4d1c46dL, 0xd3d6f4fbL, 0x4369e96aL,
-	0x346ed9fcL, 0xad678846L, 0xda60b8d0L, 0x44042d73L, 0x33031de5L,
-	0xaa0a4c5fL, 0xdd0d7cc9L, 0x5005713cL, 0x270241aaL, 0xbe0b1010L,
-	0xc90c2086L, 0x5768b525L, 0x206f85b3L, 0xb966d409L, 0xce61e49fL,
-	0x5edef90eL, 0x29d9c998L, 0xb0d09822L, 0xc7d7a8b4L, 0x59b33d17L,
-	0x2eb40d81L, 0xb7bd5c3bL, 0xc0ba6cadL, 0xedb88320L, 0x9abfb3b6L,
-	0x03b6e20cL, 0x74b1d29aL, 0xead54739L, 0x9dd277afL, 0x04db2615L,
-	0x73dc1683L, 0xe3630b12L, 0x94643b84L, 0x0d6d6a3eL, 0x7a6a5aa8L,
-	0xe40ecf0bL, 0x9309ff9dL, 0x0a00ae27L, 0x7d079eb1L, 0xf00f9344L,
-	0x8708a3d2L, 0x1e01f268L, 0x6906c2feL, 0xf762575dL, 0x806567cbL,
-	0x196c3671L, 0x6e6b06e7L, 0xfed41b76L, 0x89d32be0L, 0x10da7a5aL,
-	0x67dd4accL, 0xf9b9df6fL, 0x8ebeeff9L, 0x17b7be43L, 0x60b08ed5L,
-	0xd6d6a3e8L, 0xa1d1937eL, 0x38d8c2c4L, 0x4fdff252L, 0xd1bb67f1L,
-	0xa6bc5767L, 0x3fb506ddL, 0x48b2364bL, 0xd80d2bdaL, 0xaf0a1b4cL,
-	0x36034af6L, 0x41047a60L, 0xdf60efc3L, 0xa867df55L, 0x316e8eefL,
-	0x4669be79L, 0xcb61b38cL, 0xbc66831aL, 0x256fd2a0L, 0x5268e236L,
-	0xcc0c7795L, 0xbb0b4703L, 0x220216b9L, 0x5505262fL, 0xc5ba3bbeL,
-	0xb2bd0b28L, 0x2bb45a92L, 0x5cb36a04L, 0xc2d7ffa7L, 0xb5d0cf31L,
-	0x2cd99e8bL, 0x5bdeae1dL, 0x9b64c2b0L, 0xec63f226L, 0x756aa39cL,
-	0x026d930aL, 0x9c0906a9L, 0xeb0e363fL, 0x72076785L, 0x05005713L,
-	0x95bf4a82L, 0xe2b87a14L, 0x7bb12baeL, 0x0cb61b38L, 0x92d28e9bL,
-	0xe5d5be0dL, 0x7cdcefb7L, 0x0bdbdf21L, 0x86d3d2d4L, 0xf1d4e242L,
-	0x68ddb3f8L, 0x1fda836eL, 0x81be16cdL, 0xf6b9265bL, 0x6fb077e1L,
-	0x18b74777L, 0x88085ae6L, 0xff0f6a70L, 0x66063bcaL, 0x11010b5cL,
-	0x8f659effL, 0xf862ae69L, 0x616bffd3L, 0x166ccf45L, 0xa00ae278L,
-	0xd70dd2eeL, 0x4e048354L, 0x3903b3c2L, 0xa7672661L, 0xd06016f7L,
-	0x4969474dL, 0x3e6e77dbL, 0xaed16a4aL, 0xd9d65adcL, 0x40df0b66L,
-	0x37d83bf0L, 0xa9bcae53L, 0xdebb9ec5L, 0x47b2cf7fL, 0x30b5ffe9L,
-	0xbdbdf21cL, 0xcabac28aL, 0x53b39330L, 0x24b4a3a6L, 0xbad03605L,
-	0xcdd70693L, 0x54de5729L, 0x23d967bfL, 0xb3667a2eL, 0xc4614ab8L,
-	0x5d681b02L, 0x2a6f2b94L, 0xb40bbe37L, 0xc30c8ea1L, 0x5a05df1bL,
-	0x2d02ef8dL
-    };
     Uint crc;
     int i;
-    ssizet len;
-    char *p;
     Int cost;
 
     cost = 0;
@@ -856,10 +1588,8 @@ int kf_hash_crc32(frame *f, int nargs)
 
     crc = 0xffffffff;
     for (i = nargs; --i >= 0; ) {
-	p = f->sp[i].u.string->text;
-	for (len = f->sp[i].u.string->len; len != 0; --len) {
-	    crc = (crc >> 8) ^ crctab[UCHAR(crc ^ *p++)];
-	}
+	crc = hash_crc32(crc, f->sp[i].u.string->text,
+			 f->sp[i].u.string->len);
 	str_del(f->sp[i].u.string);
     }
     crc ^= 0xffffffffL;
@@ -1197,21 +1927,149 @@ static string *hash_sha1_end(Uint *digest, char *buffer, unsigned int bufsz, Uin
     return str_new(buffer, 20L);
 }
 
+# define ROTR(x, s)			(((x) >> s) | ((x) << (32 - s)))
+
+/*
+ * NAME:	hash->sha256_start()
+ * DESCRIPTION:	SHA-256 message digest.  See FIPS 180-2.
+ */
+static Int hash_sha256_start(frame *f, int nargs, Uint *digest)
+{
+    Int cost;
+
+    digest[0] = 0x6a09e667L;
+    digest[1] = 0xbb67ae85L;
+    digest[2] = 0x3c6ef372L;
+    digest[3] = 0xa54ff53aL;
+    digest[4] = 0x510e527fL;
+    digest[5] = 0x9b05688cL;
+    digest[6] = 0x1f83d9abL;
+    digest[7] = 0x5be0cd19L;
+
+    cost = 3 * nargs + 64;
+    while (--nargs >= 0) {
+	cost += f->sp[nargs].u.string->len;
+    }
+    return cost;
+}
+
+/*
+ * NAME:	hash->sha256_block()
+ * DESCRIPTION:	add another 512 bit block to the message digest
+ */
+static void hash_sha256_block(Uint *ABCDEFGH, char *block)
+{
+    static Uint K[64] = {
+	0x428a2f98L, 0x71374491L, 0xb5c0fbcfL, 0xe9b5dba5L, 0x3956c25bL,
+	0x59f111f1L, 0x923f82a4L, 0xab1c5ed5L, 0xd807aa98L, 0x12835b01L,
+	0x243185beL, 0x550c7dc3L, 0x72be5d74L, 0x80deb1feL, 0x9bdc06a7L,
+	0xc19bf174L, 0xe49b69c1L, 0xefbe4786L, 0x0fc19dc6L, 0x240ca1ccL,
+	0x2de92c6fL, 0x4a7484aaL, 0x5cb0a9dcL, 0x76f988daL, 0x983e5152L,
+	0xa831c66dL, 0xb00327c8L, 0xbf597fc7L, 0xc6e00bf3L, 0xd5a79147L,
+	0x06ca6351L, 0x14292967L, 0x27b70a85L, 0x2e1b2138L, 0x4d2c6dfcL,
+	0x53380d13L, 0x650a7354L, 0x766a0abbL, 0x81c2c92eL, 0x92722c85L,
+	0xa2bfe8a1L, 0xa81a664bL, 0xc24b8b70L, 0xc76c51a3L, 0xd192e819L,
+	0xd6990624L, 0xf40e3585L, 0x106aa070L, 0x19a4c116L, 0x1e376c08L,
+	0x2748774cL, 0x34b0bcb5L, 0x391c0cb3L, 0x4ed8aa4aL, 0x5b9cca4fL,
+	0x682e6ff3L, 0x748f82eeL, 0x78a5636fL, 0x84c87814L, 0x8cc70208L,
+	0x90befffaL, 0xa4506cebL, 0xbef9a3f7L, 0xc67178f2L
+    };
+    Uint W[64];
+    int i, j;
+    Uint a, b, c, d, e, f, g, h, t1, t2;
+
+    for (i = j = 0; i < 16; i++, j += 4) {
+	W[i] = (UCHAR(block[j + 0]) << 24) | (UCHAR(block[j + 1]) << 16) |
+	       (UCHAR(block[j + 2]) << 8) | UCHAR(block[j + 3]);
+    }
+    while (i < 64) {
+	t1 = W[i - 2];
+	t2 = W[i - 15];
+	W[i] = (ROTR(t1, 17) ^ ROTR(t1, 19) ^ (t1 >> 10)) + W[i - 7] +
+	       (ROTR(t2, 7) ^ ROTR(t2, 18) ^ (t2 >> 3)) + W[i - 16];
+	i++;
+    }
+
+    a = ABCDEFGH[0];
+    b = ABCDEFGH[1];
+    c = ABCDEFGH[2];
+    d = ABCDEFGH[3];
+    e = ABCDEFGH[4];
+    f = ABCDEFGH[5];
+    g = ABCDEFGH[6];
+    h = ABCDEFGH[7];
+
+    for (i = 0; i < 64; i++) {
+	t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) +
+	     (((f ^ g) & e) ^ g) + K[i] + W[i];
+	t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) +
+	     ((a & b) | ((a | b) & c));
+	h = g;
+	g = f;
+	f = e;
+	e = d + t1;
+	d = c;
+	c = b;
+	b = a;
+	a = t1 + t2;
+    }
+
+    ABCDEFGH[0] += a;
+    ABCDEFGH[1] += b;
+    ABCDEFGH[2] += c;
+    ABCDEFGH[3] += d;
+    ABCDEFGH[4] += e;
+    ABCDEFGH[5] += f;
+    ABCDEFGH[6] += g;
+    ABCDEFGH[7] += h;
+}
+
+/*
+ * NAME:	hash->sha256_end()
+ * DESCRIPTION:	finish up SHA-256 hash
+ */
+static string *hash_sha256_end(Uint *digest, char *buffer, unsigned int bufsz, Uint length)
+{
+    int i;
+
+    /* append padding and digest final block(s) */
+    buffer[bufsz++] = 0x80;
+    if (bufsz > 56) {
+	memset(buffer + bufsz, '\0', 64 - bufsz);
+	hash_sha256_block(digest, buffer);
+	bufsz = 0;
+    }
+    memset(buffer + bufsz, '\0', 64 - bufsz);
+    buffer[59] = length >> 29;
+    buffer[60] = length >> 21;
+    buffer[61] = length >> 13;
+    buffer[62] = length >> 5;
+    buffer[63] = length << 3;
+    hash_sha256_block(digest, buffer);
+
+    for (bufsz = i = 0; i < 8; bufsz += 4, i++) {
+	buffer[bufsz + 0] = digest[i] >> 24;
+	buffer[bufsz + 1] = digest[i] >> 16;
+	buffer[bufsz + 2] = digest[i] >> 8;
+	buffer[bufsz + 3] = digest[i];
+    }
+    return str_new(buffer, 32L);
+}
+
 /*
  * NAME:	hash->blocks()
- * DESCRIPTION:	hash string blocks with a given function
+ * DESCRIPTION:	hash string blocks with a given function, continuing from
+ *		a partially filled buffer
  */
-static Uint hash_blocks(frame *f, int nargs, Uint *digest, char *buffer,
-	unsigned short *bufsize, unsigned int blocksz,
+static Uint hash_blocks(frame *f, int nargs, Uint length, Uint *digest,
+	char *buffer, unsigned short *bufsize, unsigned int blocksz,
 	void (*hash_block) (Uint*, char*))
 {
     ssizet len;
     unsigned short bufsz;
     char *p;
-    Uint length;
 
-    length = 0;
-    bufsz = 0;
+    bufsz = *bufsize;
     while (--nargs >= 0) {
 	len = f->sp[nargs].u.string->len;
 	if (len != 0) {
@@ -1274,7 +2132,9 @@ void kf_md5(frame *f, int nargs, value *val)
     }
     i_add_ticks(f, cost);
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64, &hash_md5_block);
+    bufsz = 0;
+    length = hash_blocks(f, nargs, 0, digest, buffer, &bufsz, 64,
+			 &hash_md5_block);
     str = hash_md5_end(digest, buffer, bufsz, length);
     PUT_STRVAL_NOREF(val, str);
 }
@@ -1299,11 +2159,39 @@ void kf_sha1(frame *f, int nargs, value *val)
     }
     i_add_ticks(f, cost);
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64,
+    bufsz = 0;
+    length = hash_blocks(f, nargs, 0, digest, buffer, &bufsz, 64,
 			 &hash_sha1_block);
     str = hash_sha1_end(digest, buffer, bufsz, length);
     PUT_STRVAL_NOREF(val, str);
 }
+
+/*
+ * NAME:	kfun->sha256()
+ * DESCRIPTION:	compute SHA-256 hash
+ */
+void kf_sha256(frame *f, int nargs, value *val)
+{
+    char buffer[64];
+    Uint digest[8];
+    Int cost;
+    Uint length;
+    unsigned short bufsz;
+    string *str;
+
+    cost = hash_sha256_start(f, nargs, digest);
+    if (!f->rlim->noticks && f->rlim->ticks <= cost) {
+	f->rlim->ticks = 0;
+	error("Out of ticks");
+    }
+    i_add_ticks(f, cost);
+
+    bufsz = 0;
+    length = hash_blocks(f, nargs, 0, digest, buffer, &bufsz, 64,
+			 &hash_sha256_block);
+    str = hash_sha256_end(digest, buffer, bufsz, length);
+    PUT_STRVAL_NOREF(val, str);
+}
 # endif
 
 
@@ -1355,7 +2243,9 @@ int kf_hash_md5(frame *f, int nargs)
     }
     i_add_ticks(f, cost);
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64, &hash_md5_block);
+    bufsz = 0;
+    length = hash_blocks(f, nargs, 0, digest, buffer, &bufsz, 64,
+			 &hash_md5_block);
 
     i_pop(f, nargs);
     PUSH_STRVAL(f, hash_md5_end(digest, buffer, bufsz, length));
@@ -1389,7 +2279,8 @@ int kf_hash_sha1(frame *f, int nargs)
     }
     i_add_ticks(f, cost);
 
-    length = hash_blocks(f, nargs, digest, buffer, &bufsz, 64,
+    bufsz = 0;
+    length = hash_blocks(f, nargs, 0, digest, buffer, &bufsz, 64,
 			 &hash_sha1_block);
 
     i_pop(f, nargs);
@@ -1399,6 +2290,229 @@ int kf_hash_sha1(frame *f, int nargs)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("hash_init", kf_hash_init, pt_hash_init, 0)
+# else
+char pt_hash_init[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_STRING,
+			T_STRING };
+
+typedef struct {
+    char *name;				/* name of algorithm */
+    short size;				/* digest size in words */
+    Int (*start) (frame*, int, Uint*);	/* initialize digest */
+    void (*block) (Uint*, char*);	/* add block to digest */
+    string *(*end) (Uint*, char*, unsigned int, Uint); /* finish digest */
+} hashalg;
+
+# define HASH_CRC16	3		/* first CRC algorithm */
+# define HASH_CRC32	4
+
+static hashalg hashalgs[] = {
+    { "MD5", 4, &hash_md5_start, &hash_md5_block, &hash_md5_end },
+    { "SHA1", 5, &hash_sha1_start, &hash_sha1_block, &hash_sha1_end },
+    { "SHA256", 8, &hash_sha256_start, &hash_sha256_block, &hash_sha256_end },
+    { "CRC16", 1, NULL, NULL, NULL },
+    { "CRC32", 1, NULL, NULL, NULL }
+};
+
+/*
+ * NAME:	hash->get_context()
+ * DESCRIPTION:	decode a hash context, which consists of the algorithm, the
+ *		length of the data hashed so far, the digest and the
+ *		remainder of the data that does not fill a whole block
+ */
+static int hash_get_context(string *str, Uint *length, Uint *digest,
+			    char *buffer, unsigned short *bufsz)
+{
+    char *p;
+    int alg, i;
+    ssizet len;
+
+    p = str->text;
+    len = str->len;
+    alg = UCHAR(*p);
+    if (len < 5 || alg >= sizeof(hashalgs) / sizeof(hashalg) ||
+	len < 5 + (hashalgs[alg].size << 2)) {
+	error("Invalid hash context");
+    }
+    len -= 5 + (hashalgs[alg].size << 2);
+
+    *length = (UCHAR(p[1]) << 24) | (UCHAR(p[2]) << 16) | (UCHAR(p[3]) << 8) |
+	      UCHAR(p[4]);
+    p += 5;
+    for (i = 0; i < hashalgs[alg].size; i++, p += 4) {
+	digest[i] = (UCHAR(p[0]) << 24) | (UCHAR(p[1]) << 16) |
+		    (UCHAR(p[2]) << 8) | UCHAR(p[3]);
+    }
+    if (len != ((alg < HASH_CRC16) ? (*length & 63) : 0)) {
+	error("Invalid hash context");
+    }
+    memcpy(buffer, p, *bufsz = len);
+
+    return alg;
+}
+
+/*
+ * NAME:	hash->put_context()
+ * DESCRIPTION:	encode a hash context
+ */
+static string *hash_put_context(int alg, Uint length, Uint *digest,
+				char *buffer, unsigned short bufsz)
+{
+    string *str;
+    char *p;
+    int i;
+
+    str = str_new((char *) NULL, 5L + (hashalgs[alg].size << 2) + bufsz);
+    p = str->text;
+    *p++ = alg;
+    *p++ = length >> 24;
+    *p++ = length >> 16;
+    *p++ = length >> 8;
+    *p++ = length;
+    for (i = 0; i < hashalgs[alg].size; i++) {
+	*p++ = digest[i] >> 24;
+	*p++ = digest[i] >> 16;
+	*p++ = digest[i] >> 8;
+	*p++ = digest[i];
+    }
+    memcpy(p, buffer, bufsz);
+
+    return str;
+}
+
+/*
+ * NAME:	kfun->hash_init()
+ * DESCRIPTION:	start an incremental hash
+ */
+int kf_hash_init(frame *f)
+{
+    Uint digest[8];
+    int alg;
+    string *str;
+
+    for (alg = 0; strcmp(f->sp->u.string->text, hashalgs[alg].name) != 0; ) {
+	if (++alg == sizeof(hashalgs) / sizeof(hashalg)) {
+	    error("Unknown hash algorithm");
+	}
+    }
+    if (alg == HASH_CRC16) {
+	digest[0] = 0xffff;
+    } else if (alg == HASH_CRC32) {
+	digest[0] = 0xffffffffL;
+    } else {
+	(*hashalgs[alg].start)(f, 0, digest);
+    }
+
+    str = hash_put_context(alg, 0, digest, (char *) NULL, 0);
+    str_del(f->sp->u.string);
+    PUT_STR(f->sp, str);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("hash_update", kf_hash_update, pt_hash_update, 0)
+# else
+char pt_hash_update[] = { C_TYPECHECKED | C_STATIC | C_ELLIPSIS, 1, 1, 0, 8,
+			  T_STRING, T_STRING, T_STRING };
+
+/*
+ * NAME:	kfun->hash_update()
+ * DESCRIPTION:	add strings to an incremental hash
+ */
+int kf_hash_update(frame *f, int nargs)
+{
+    char buffer[64];
+    Uint digest[8];
+    int alg, i;
+    Int cost;
+    Uint length;
+    unsigned short bufsz;
+    string *str;
+
+    alg = hash_get_context(f->sp[nargs - 1].u.string, &length, digest,
+			   buffer, &bufsz);
+
+    cost = 0;
+    for (i = nargs - 1; --i >= 0; ) {
+	cost += f->sp[i].u.string->len;
+    }
+    cost = 3 * nargs + ((alg < HASH_CRC16) ? cost : cost >> 2);
+    if (!f->rlim->noticks && f->rlim->ticks <= cost) {
+	f->rlim->ticks = 0;
+	error("Out of ticks");
+    }
+    i_add_ticks(f, cost);
+
+    if (alg < HASH_CRC16) {
+	length = hash_blocks(f, nargs - 1, length, digest, buffer, &bufsz, 64,
+			     hashalgs[alg].block);
+    } else {
+	for (i = nargs - 1; --i >= 0; ) {
+	    str = f->sp[i].u.string;
+	    if (alg == HASH_CRC16) {
+		digest[0] = hash_crc16(digest[0], str->text, str->len);
+	    } else {
+		digest[0] = hash_crc32(digest[0], str->text, str->len);
+	    }
+	    length += str->len;
+	}
+    }
+
+    str = hash_put_context(alg, length, digest, buffer, bufsz);
+    i_pop(f, nargs);
+    PUSH_STRVAL(f, str);
+    return 0;
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("hash_final", kf_hash_final, pt_hash_final, 0)
+# else
+char pt_hash_final[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_MIXED,
+			 T_STRING };
+
+/*
+ * NAME:	kfun->hash_final()
+ * DESCRIPTION:	finish an incremental hash, returning the digest as a string,
+ *		or the CRC as an integer
+ */
+int kf_hash_final(frame *f)
+{
+    char buffer[64];
+    Uint digest[8];
+    int alg;
+    Uint length;
+    unsigned short bufsz;
+    string *str;
+
+    alg = hash_get_context(f->sp->u.string, &length, digest, buffer, &bufsz);
+    str_del(f->sp->u.string);
+
+    switch (alg) {
+    case HASH_CRC16:
+	digest[0] &= 0xffff;
+	PUT_INTVAL(f->sp, ((digest[0] >> 8) + (digest[0] << 8)) & 0xffff);
+	break;
+
+    case HASH_CRC32:
+	PUT_INTVAL(f->sp, digest[0] ^ 0xffffffffL);
+	break;
+
+    default:
+	i_add_ticks(f, 64);
+	str = (*hashalgs[alg].end)(digest, buffer, bufsz, length);
+	PUT_STRVAL(f->sp, str);
+	break;
+    }
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("asn_add", kf_asn_add, pt_asn_add, 0)
 # else
@@ -103,9 +103,7 @@ int kf_query_editor(frame *f)
 # endif
 
 
-# ifdef FUNCDEF
-FUNCDEF("save_object", kf_save_object, pt_save_object, 0)
-# else
+# ifndef FUNCDEF
 typedef struct {
     int fd;			/* save/restore file descriptor */
     char *buffer;		/* save/restore buffer */
@@ -113,6 +111,19 @@ typedef struct {
     Uint narrays;		/* number of arrays/mappings encountered */
 } savecontext;
 
+# define SAVE_MAGIC	"\177DGD"	/* binary save file magic */
+# define SAVE_MAGICSZ	4
+# define SAVE_VERSION	1		/* binary save file version */
+
+# define SV_NIL		0		/* nil */
+# define SV_INT		1		/* zigzag-encoded integer */
+# define SV_FLOAT	2		/* float, exact bits */
+# define SV_STRING	3		/* length-prefixed string */
+# define SV_ARRAY	4		/* array */
+# define SV_MAPPING	5		/* mapping */
+# define SV_ARRREF	6		/* reference to earlier array */
+# define SV_MAPREF	7		/* reference to earlier mapping */
+
 /*
  * NAME:	put()
  * DESCRIPTION:	output a number of characters
@@ -362,14 +373,154 @@ static void save_mapping(savecontext *x, array *a)
     put(x, "])", 2);
 }
 
-char pt_save_object[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_VOID,
-			  T_STRING };
+/*
+ * NAME:	put_count()
+ * DESCRIPTION:	output a variable-length unsigned number
+ */
+static void put_count(savecontext *x, Uint n)
+{
+    char buf[5];
+    int len;
+
+    for (len = 0; n >= 0x80; n >>= 7) {
+	buf[len++] = (n & 0x7f) | 0x80;
+    }
+    buf[len++] = n;
+    put(x, buf, len);
+}
+
+static void save_bmapping (savecontext*, array*);
 
 /*
- * NAME:	kfun->save_object()
- * DESCRIPTION:	save the variables of the current object
+ * NAME:	save_bvalue()
+ * DESCRIPTION:	save a value in binary format
+ */
+static void save_bvalue(savecontext *x, value *v)
+{
+    char buf[7];
+    Uint i;
+    value *w;
+    xfloat flt;
+
+    switch (v->type) {
+    case T_NIL:
+	buf[0] = SV_NIL;
+	put(x, buf, 1);
+	break;
+
+    case T_INT:
+	buf[0] = SV_INT;
+	put(x, buf, 1);
+	put_count(x, (v->u.number < 0) ?
+		      ~((Uint) v->u.number << 1) : (Uint) v->u.number << 1);
+	break;
+
+    case T_FLOAT:
+	GET_FLT(v, flt);
+	buf[0] = SV_FLOAT;
+	buf[1] = flt.high >> 8;
+	buf[2] = flt.high;
+	buf[3] = flt.low >> 24;
+	buf[4] = flt.low >> 16;
+	buf[5] = flt.low >> 8;
+	buf[6] = flt.low;
+	put(x, buf, 7);
+	break;
+
+    case T_STRING:
+	buf[0] = SV_STRING;
+	put(x, buf, 1);
+	put_count(x, (Uint) v->u.string->len);
+	put(x, v->u.string->text, v->u.string->len);
+	break;
+
+    case T_OBJECT:
+    case T_LWOBJECT:
+	if (conf_typechecking() >= 2) {
+	    buf[0] = SV_NIL;
+	    put(x, buf, 1);
+	} else {
+	    buf[0] = SV_INT;
+	    buf[1] = 0;
+	    put(x, buf, 2);
+	}
+	break;
+
+    case T_ARRAY:
+	i = arr_put(v->u.array, x->narrays);
+	if (i < x->narrays) {
+	    /* same as some previous array */
+	    buf[0] = SV_ARRREF;
+	    put(x, buf, 1);
+	    put_count(x, i);
+	    break;
+	}
+	x->narrays++;
+
+	buf[0] = SV_ARRAY;
+	put(x, buf, 1);
+	put_count(x, (Uint) v->u.array->size);
+	for (i = v->u.array->size, w = d_get_elts(v->u.array); i > 0; --i) {
+	    save_bvalue(x, w++);
+	}
+	break;
+
+    case T_MAPPING:
+	save_bmapping(x, v->u.array);
+	break;
+    }
+}
+
+/*
+ * NAME:	save_bmapping()
+ * DESCRIPTION:	save a mapping in binary format
  */
-int kf_save_object(frame *f)
+static void save_bmapping(savecontext *x, array *a)
+{
+    char buf[1];
+    Uint i, n;
+    value *v;
+
+    i = arr_put(a, x->narrays);
+    if (i < x->narrays) {
+	/* same as some previous mapping */
+	buf[0] = SV_MAPREF;
+	put(x, buf, 1);
+	put_count(x, i);
+	return;
+    }
+    x->narrays++;
+    map_compact(a->primary->data, a);
+
+    /*
+     * skip index/value pairs of which either is an object
+     */
+    for (i = n = a->size >> 1, v = d_get_elts(a); i > 0; --i, v += 2) {
+	if (v[0].type == T_OBJECT || v[0].type == T_LWOBJECT ||
+	    v[1].type == T_OBJECT || v[1].type == T_LWOBJECT) {
+	    --n;
+	}
+    }
+    buf[0] = SV_MAPPING;
+    put(x, buf, 1);
+    put_count(x, n);
+
+    for (i = a->size >> 1, v = a->elts; i > 0; --i, v += 2) {
+	if (v[0].type == T_OBJECT || v[0].type == T_LWOBJECT ||
+	    v[1].type == T_OBJECT || v[1].type == T_LWOBJECT) {
+	    continue;
+	}
+	save_bvalue(x, &v[0]);
+	save_bvalue(x, &v[1]);
+    }
+}
+
+/*
+ * NAME:	save_object()
+ * DESCRIPTION:	save the variables of the current object, in text or
+ *		binary format
+ */
+static int save_object(frame *f, bool binary)
 {
     static unsigned short count;
     unsigned short i, j, nvars;
@@ -406,6 +557,12 @@ int kf_save_object(frame *f)
     x.buffer = ALLOCA(char, BUF_SIZE);
     x.bufsz = 0;
 
+    if (binary) {
+	put(&x, SAVE_MAGIC, SAVE_MAGICSZ);
+	buf[0] = SAVE_VERSION;
+	put(&x, buf, 1);
+    }
+
     ctrl = f->ctrl;
     arr_merge();
     x.narrays = 0;
@@ -435,6 +592,14 @@ int kf_save_object(frame *f)
 		     * don't save object values, nil or 0
 		     */
 		    str = d_get_strconst(ctrl, v->inherit, v->index);
+		    if (binary) {
+			put_count(&x, (Uint) str->len);
+			put(&x, str->text, str->len);
+			save_bvalue(&x, var);
+			var++;
+			nvars++;
+			continue;
+		    }
 		    put(&x, str->text, str->len);
 		    put(&x, " ", 1);
 		    switch (var->type) {
@@ -494,6 +659,47 @@ int kf_save_object(frame *f)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("0.save_object", kf_old_save_object, pt_old_save_object, 0)
+# else
+char pt_old_save_object[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_VOID,
+			      T_STRING };
+
+/*
+ * NAME:	kfun->old_save_object()
+ * DESCRIPTION:	save the variables of the current object
+ */
+int kf_old_save_object(frame *f)
+{
+    return save_object(f, FALSE);
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("save_object", kf_save_object, pt_save_object, 1)
+# else
+char pt_save_object[] = { C_TYPECHECKED | C_STATIC, 1, 1, 0, 8, T_VOID,
+			  T_STRING, T_INT };
+
+/*
+ * NAME:	kfun->save_object()
+ * DESCRIPTION:	save the variables of the current object, optionally in
+ *		binary format
+ */
+int kf_save_object(frame *f, int nargs)
+{
+    bool binary;
+
+    binary = FALSE;
+    if (nargs == 2) {
+	binary = ((f->sp++)->u.number != 0);
+    }
+    return save_object(f, binary);
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("restore_object", kf_restore_object, pt_restore_object, 0)
 # else
@@ -505,11 +711,14 @@ typedef struct _achunk_ {
 } achunk;
 
 typedef struct {
-    int line;			/* current line number */
+    int line;			/* current line number or offset */
     frame *f;			/* interpreter frame */
     achunk *alist;		/* list of array chunks */
     int achunksz;		/* size of current array chunk */
     Uint narrays;		/* # of arrays/mappings */
+    bool binary;		/* binary save file? */
+    char *start;		/* start of restore buffer */
+    char *end;			/* end of restore buffer */
     char file[STRINGSZ];	/* current restore file */
 } restcontext;
 
@@ -570,6 +779,10 @@ static void ac_clear(restcontext *x)
  */
 static void restore_error(restcontext *x, char *err)
 {
+    if (x->binary) {
+	error("Format error in \"/%s\", offset %ld: %s", x->file,
+	      (long) x->line, err);
+    }
     error("Format error in \"/%s\", line %d: %s", x->file, x->line, err);
 }
 
@@ -862,6 +1075,202 @@ static char *restore_value(restcontext *x, char *buf, value *val)
     }
 }
 
+/*
+ * NAME:	restore_count()
+ * DESCRIPTION:	restore a variable-length unsigned number
+ */
+static char *restore_count(restcontext *x, char *buf, Uint *n)
+{
+    int shift;
+    Uint c;
+
+    *n = 0;
+    for (shift = 0; ; shift += 7) {
+	/* at most 5 bytes, the last of which holds the top 4 bits */
+	if (buf == x->end || (shift == 28 && UCHAR(*buf) > 0x0f)) {
+	    x->line = buf - x->start;
+	    restore_error(x, "bad count");
+	}
+	c = UCHAR(*buf++);
+	*n |= (c & 0x7f) << shift;
+	if (!(c & 0x80)) {
+	    return buf;
+	}
+    }
+}
+
+static char *restore_bvalue	(restcontext*, char*, value*);
+
+/*
+ * NAME:	restore_barray()
+ * DESCRIPTION:	restore an array or mapping in binary format
+ */
+static char *restore_barray(restcontext *x, char *buf, value *val, short type)
+{
+    Uint i, n;
+    value *v;
+    array *a;
+
+    buf = restore_count(x, buf, &n);
+    if (type == T_ARRAY) {
+	a = arr_new(x->f->data, (long) n);
+    } else {
+	a = map_new(x->f->data, (long) n << 1);
+    }
+    ac_put(x, type, a);
+    for (i = a->size, v = a->elts; i > 0; --i) {
+	*v++ = nil_value;
+    }
+    if (ec_push((ec_ftn) NULL)) {
+	arr_ref(a);
+	arr_del(a);
+	error((char *) NULL);	/* pass on the error */
+    }
+    /* restore the values */
+    for (i = a->size, v = a->elts; i > 0; --i) {
+	buf = restore_bvalue(x, buf, v);
+	i_ref_value(v++);
+    }
+    if (type == T_MAPPING) {
+	map_sort(a);
+    }
+    ec_pop();
+
+    val->type = type;
+    val->u.array = a;
+    return buf;
+}
+
+/*
+ * NAME:	restore_bvalue()
+ * DESCRIPTION:	restore a value in binary format
+ */
+static char *restore_bvalue(restcontext *x, char *buf, value *val)
+{
+    Uint n;
+    xfloat flt;
+
+    x->line = buf - x->start;
+    if (buf == x->end) {
+	restore_error(x, "value expected");
+    }
+    switch (*buf++) {
+    case SV_NIL:
+	*val = nil_value;
+	return buf;
+
+    case SV_INT:
+	buf = restore_count(x, buf, &n);
+	PUT_INTVAL(val, (n & 1) ? ~(Int) (n >> 1) : (Int) (n >> 1));
+	return buf;
+
+    case SV_FLOAT:
+	if (x->end - buf < 6) {
+	    restore_error(x, "truncated float");
+	}
+	flt.high = (UCHAR(buf[0]) << 8) | UCHAR(buf[1]);
+	if ((flt.high & 0x7ff0) == 0x7ff0) {
+	    restore_error(x, "illegal exponent");
+	}
+	flt.low = ((Uint) UCHAR(buf[2]) << 24) | ((Uint) UCHAR(buf[3]) << 16) |
+		  ((Uint) UCHAR(buf[4]) << 8) | UCHAR(buf[5]);
+	PUT_FLTVAL(val, flt);
+	return buf + 6;
+
+    case SV_STRING:
+	buf = restore_count(x, buf, &n);
+	if (n > (Uint) (x->end - buf)) {
+	    restore_error(x, "truncated string");
+	}
+	PUT_STRVAL_NOREF(val, str_new(buf, (long) n));
+	return buf + n;
+
+    case SV_ARRAY:
+	return restore_barray(x, buf, val, T_ARRAY);
+
+    case SV_MAPPING:
+	return restore_barray(x, buf, val, T_MAPPING);
+
+    case SV_ARRREF:
+	buf = restore_count(x, buf, &n);
+	if (n >= x->narrays || ac_get(x, n)->type != T_ARRAY) {
+	    restore_error(x, "bad array reference");
+	}
+	*val = *ac_get(x, n);
+	return buf;
+
+    case SV_MAPREF:
+	buf = restore_count(x, buf, &n);
+	if (n >= x->narrays || ac_get(x, n)->type != T_MAPPING) {
+	    restore_error(x, "bad mapping reference");
+	}
+	*val = *ac_get(x, n);
+	return buf;
+
+    default:
+	restore_error(x, "bad value type");
+	return buf;
+    }
+}
+
+/*
+ * NAME:	skip_bvalue()
+ * DESCRIPTION:	skip a value in binary format, numbering the arrays and
+ *		mappings it contains
+ */
+static char *skip_bvalue(restcontext *x, char *buf)
+{
+    Uint n;
+
+    x->line = buf - x->start;
+    if (buf == x->end) {
+	restore_error(x, "value expected");
+    }
+    switch (*buf++) {
+    case SV_NIL:
+	return buf;
+
+    case SV_INT:
+    case SV_ARRREF:
+    case SV_MAPREF:
+	return restore_count(x, buf, &n);
+
+    case SV_FLOAT:
+	if (x->end - buf < 6) {
+	    restore_error(x, "truncated float");
+	}
+	return buf + 6;
+
+    case SV_STRING:
+	buf = restore_count(x, buf, &n);
+	if (n > (Uint) (x->end - buf)) {
+	    restore_error(x, "truncated string");
+	}
+	return buf + n;
+
+    case SV_MAPPING:
+	buf = restore_count(x, buf, &n);
+	ac_put(x, T_NIL, (array *) NULL);
+	for (n <<= 1; n > 0; --n) {
+	    buf = skip_bvalue(x, buf);
+	}
+	return buf;
+
+    case SV_ARRAY:
+	buf = restore_count(x, buf, &n);
+	ac_put(x, T_NIL, (array *) NULL);
+	while (n > 0) {
+	    buf = skip_bvalue(x, buf);
+	    --n;
+	}
+	return buf;
+
+    default:
+	restore_error(x, "bad value type");
+	return buf;
+    }
+}
+
 char pt_restore_object[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_INT,
 			     T_STRING };
 
@@ -884,7 +1293,10 @@ int kf_restore_object(frame *f)
     object *obj;
     int fd;
     char *buffer, *name;
+    unsigned int namelen;
+    Uint count;
     bool onstack, pending;
+    string *str;
 
     obj = OBJR(f->oindex);
     if (path_string(x.file, f->sp->u.string->text,
@@ -968,7 +1380,9 @@ int kf_restore_object(frame *f)
     x.alist = (achunk *) NULL;
     x.achunksz = ACHUNKSZ;
     x.narrays = 0;
-    buf = buffer;
+    x.binary = FALSE;
+    x.start = buf = buffer;
+    x.end = buffer + sbuf.st_size;
     pending = FALSE;
     if (ec_push((ec_ftn) NULL)) {
 	/* error; clean up */
@@ -980,6 +1394,18 @@ int kf_restore_object(frame *f)
 	}
 	error((char *) NULL);	/* pass on error */
     }
+    if (sbuf.st_size > SAVE_MAGICSZ &&
+	memcmp(buffer, SAVE_MAGIC, SAVE_MAGICSZ) == 0) {
+	/*
+	 * binary save file
+	 */
+	x.binary = TRUE;
+	x.line = SAVE_MAGICSZ;
+	if (buffer[SAVE_MAGICSZ] != SAVE_VERSION) {
+	    restore_error(&x, "unsupported version");
+	}
+	buf += SAVE_MAGICSZ + 1;
+    }
     for (;;) {
 	if (f->lwobj != (array *) NULL) {
 	    var = &f->lwobj->elts[2];
@@ -1005,14 +1431,36 @@ int kf_restore_object(frame *f)
 			 * The saved variable is not in this object.
 			 * Skip it.
 			 */
-			buf = strchr(buf, LF);
-			if (buf == (char *) NULL) {
-			    restore_error(&x, "'\\n' expected");
+			if (x.binary) {
+			    buf = skip_bvalue(&x, buf);
+			} else {
+			    buf = strchr(buf, LF);
+			    if (buf == (char *) NULL) {
+				restore_error(&x, "'\\n' expected");
+			    }
+			    buf++;
+			    x.line++;
 			}
-			buf++;
-			x.line++;
 			pending = FALSE;
 		    }
+		    if (!pending && x.binary) {
+			/*
+			 * get a new length-prefixed variable name
+			 */
+			if (buf == x.end) {
+			    /* end of file */
+			    break;
+			}
+			buf = restore_count(&x, buf, &count);
+			if (count == 0 || count > (Uint) (x.end - buf)) {
+			    restore_error(&x, "bad variable name");
+			}
+			name = buf;
+			namelen = count;
+			buf += count;
+			pending = TRUE;		/* start checking variables */
+			checkpoint = nvars;	/* from here */
+		    }
 		    if (!pending) {
 			/*
 			 * get a new variable name from the save file
@@ -1042,20 +1490,26 @@ int kf_restore_object(frame *f)
 			    restore_error(&x, "' ' expected");
 			}
 
+			namelen = buf - name;
 			*buf++ = '\0';		/* terminate name */
 			pending = TRUE;		/* start checking variables */
 			checkpoint = nvars;	/* from here */
 		    }
 
 		    if (!(v->class & C_STATIC) &&
-			strcmp(name, d_get_strconst(ctrl, v->inherit,
-						    v->index)->text) == 0) {
+			(str = d_get_strconst(ctrl, v->inherit,
+					      v->index))->len == namelen &&
+			memcmp(name, str->text, namelen) == 0) {
 			value tmp;
 
 			/*
 			 * found the proper variable to restore
 			 */
-			buf = restore_value(&x, buf, &tmp);
+			if (x.binary) {
+			    buf = restore_bvalue(&x, buf, &tmp);
+			} else {
+			    buf = restore_value(&x, buf, &tmp);
+			}
 			if (v->type != tmp.type && v->type != T_MIXED &&
 			    conf_typechecking() &&
 			    (!VAL_NIL(&tmp) || !T_POINTER(v->type)) &&
@@ -1069,16 +1523,18 @@ int kf_restore_object(frame *f)
 			} else {
 			    d_assign_var(data, var, &tmp);
 			}
-			if (*buf++ != LF) {
-			    restore_error(&x, "'\\n' expected");
+			if (!x.binary) {
+			    if (*buf++ != LF) {
+				restore_error(&x, "'\\n' expected");
+			    }
+			    x.line++;
 			}
-			x.line++;
 			pending = FALSE;
 		    }
 		    var++;
 		    nvars++;
 		}
-		if (!pending && *buf == '\0') {
+		if (!pending && ((x.binary) ? buf == x.end : *buf == '\0')) {
 		    /*
 		     * finished restoring
 		     */
@@ -1174,9 +1630,10 @@ char pt_read_file[] = { C_TYPECHECKED | C_STATIC, 1, 2, 0, 9, T_STRING,
  */
 int kf_read_file(frame *f, int nargs)
 {
-    char file[STRINGSZ], *buf;
+    char file[STRINGSZ];
     struct stat sbuf;
-    Int l, size;
+    Int l, size, len;
+    string *str;
     static int fd;
 
     l = 0;
@@ -1215,15 +1672,14 @@ int kf_read_file(frame *f, int nargs)
 
     if (l != 0) {
 	/*
-	 * seek in file
+	 * offset in file
 	 */
 	if (l < 0) {
 	    /* offset from end of file */
 	    l += sbuf.st_size;
 	}
-	if (l < 0 || l > sbuf.st_size ||
-	    (l != 0 && P_lseek(fd, l, SEEK_SET) < 0)) {
-	    /* bad seek */
+	if (l < 0 || l > sbuf.st_size) {
+	    /* bad offset */
 	    P_close(fd);
 	    return 2;
 	}
@@ -1237,23 +1693,31 @@ int kf_read_file(frame *f, int nargs)
 	P_close(fd);
 	error("String too long");
     }
-    buf = (size != 0) ? ALLOCA(char, size) : (char *) NULL;
-    if (size > 0 && (size=P_read(fd, buf, (unsigned int) size)) < 0) {
-	/* read failed */
-	P_close(fd);
-	if (buf != (char *) NULL) {
-	    AFREE(buf);
-	}
-	error("Read failed in read_file()");
-    }
-    P_close(fd);
-    i_add_ticks(f, 2 * size);
 
-    PUT_STRVAL(f->sp, str_new((char *) buf, size));
-    if (buf != (char *) NULL) {
-	AFREE(buf);
+    /*
+     * read directly into the result string
+     */
+    str = str_new((char *) NULL, (long) size);
+    len = (size > 0) ?
+	   P_pread(fd, str->text, (unsigned int) size, (off_t) l) : 0;
+    P_close(fd);
+    if (len != size) {
+	string *tmp;
+
+	tmp = str;
+	str_ref(tmp);
+	if (len < 0) {
+	    /* read failed */
+	    str_del(tmp);
+	    error("Read failed in read_file()");
+	}
+	/* file shrunk while reading */
+	str = str_new(tmp->text, (long) len);
+	str_del(tmp);
     }
+    i_add_ticks(f, 2 * len);
 
+    PUT_STRVAL(f->sp, str);
     return 0;
 }
 # endif
@@ -1382,7 +1846,7 @@ int kf_remove_dir(frame *f)
 
 
 # ifdef FUNCDEF
-FUNCDEF("get_dir", kf_get_dir, pt_get_dir, 0)
+FUNCDEF("0.get_dir", kf_old_get_dir, pt_old_get_dir, 0)
 # else
 /*
  * NAME:	match()
@@ -1485,17 +1949,35 @@ static int match(char *pat, char *text)
     }
 }
 
-typedef struct _fileinfo_ {
-    string *name;		/* file name */
+typedef struct {
+    Uint name;			/* offset of file name */
+    unsigned short len;		/* length of file name */
     Int size;			/* file size */
     Int time;			/* file time */
 } fileinfo;
 
+typedef struct {
+    char dir[STRINGSZ];		/* directory, or empty if unused */
+    int wd;			/* watch descriptor */
+    ino_t ino;			/* inode of directory */
+    Uint stamp;			/* last use */
+    Uint nfiles;		/* # files */
+    fileinfo *files;		/* files, sorted by name */
+    char *names;		/* file names */
+} dirinfo;
+
+# define FILEINFO_CHUNK	1024
+# define DIRCACHESZ	16	/* # of cached directory listings */
+
+static dirinfo dircache[DIRCACHESZ];	/* directory listing cache */
+static Uint dirstamp;			/* directory cache use stamp */
+static char *cmpnames;			/* file names to compare */
+
 /*
  * NAME:	getinfo()
  * DESCRIPTION:	get info about a file
  */
-static bool getinfo(char *path, char *file, fileinfo *finf)
+static bool getinfo(char *path, fileinfo *finf)
 {
     struct stat sbuf;
 
@@ -1506,7 +1988,6 @@ static bool getinfo(char *path, char *file, fileinfo *finf)
 	return FALSE;
     }
 
-    str_ref(finf->name = str_new(file, (long) strlen(file)));
     if ((sbuf.st_mode & S_IFMT) == S_IFDIR) {
 	finf->size = -2;	/* special value for directory */
     } else {
@@ -1525,26 +2006,177 @@ static int cmp (cvoid*, cvoid*);
  */
 static int cmp(cvoid *cv1, cvoid *cv2)
 {
-    return strcmp(((fileinfo *) cv1)->name->text,
-		  ((fileinfo *) cv2)->name->text);
+    return strcmp(cmpnames + ((fileinfo *) cv1)->name,
+		  cmpnames + ((fileinfo *) cv2)->name);
 }
 
-char pt_get_dir[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
-		      T_MIXED | (2 << REFSHIFT), T_STRING };
+/*
+ * NAME:	dir_read()
+ * DESCRIPTION:	read the files matching a pattern from a directory, or all
+ *		files if there is no pattern, and sort them by name
+ */
+static bool dir_read(char *dir, char *pat, dirinfo *d, Uint *namesz)
+{
+    char *file, buf[STRINGSZ];
+    Uint ftabsz, size, len, dirlen;
+
+    d->nfiles = 0;
+    d->files = (fileinfo *) NULL;
+    d->names = (char *) NULL;
+    *namesz = 0;
+    if (!P_opendir(dir)) {
+	return FALSE;
+    }
 
-# define FILEINFO_CHUNK	1024
+    /*
+     * read all files from directory, so that a slice can be selected from
+     * the sorted list
+     */
+    d->files = ALLOC(fileinfo, ftabsz = FILEINFO_CHUNK);
+    size = 0;
+    dirlen = strlen(dir);
+    while ((file=P_readdir()) != (char *) NULL) {
+	len = strlen(file);
+	if (dirlen + len + 2 > STRINGSZ ||
+	    (pat != (char *) NULL && match(pat, file) <= 0)) {
+	    continue;
+	}
+	sprintf(buf, "%s/%s", dir, file);
+	if (getinfo(buf, &d->files[d->nfiles])) {
+	    /* add file */
+	    if (size + len + 1 > *namesz) {
+		d->names = REALLOC(d->names, char, *namesz,
+				   *namesz + FILEINFO_CHUNK * 16 + len);
+		*namesz += FILEINFO_CHUNK * 16 + len;
+	    }
+	    memcpy(d->names + size, file, len + 1);
+	    d->files[d->nfiles].name = size;
+	    d->files[d->nfiles].len = len;
+	    size += len + 1;
+	    if (++d->nfiles == ftabsz) {
+		d->files = REALLOC(d->files, fileinfo, ftabsz,
+				   ftabsz + FILEINFO_CHUNK);
+		ftabsz += FILEINFO_CHUNK;
+	    }
+	}
+    }
+    P_closedir();
+    *namesz = size;
+
+    cmpnames = d->names;
+    qsort(d->files, d->nfiles, sizeof(fileinfo), cmp);
+    return TRUE;
+}
 
 /*
- * NAME:	kfun->get_dir()
- * DESCRIPTION:	get directory filelist + info
+ * NAME:	dir_uncache()
+ * DESCRIPTION:	remove a directory listing from the cache
  */
-int kf_get_dir(frame *f)
+static void dir_uncache(dirinfo *d)
 {
-    unsigned int i, nfiles, ftabsz;
-    fileinfo *ftable;
+    P_unwatchdir(d->wd);
+    if (d->files != (fileinfo *) NULL) {
+	FREE(d->files);
+    }
+    if (d->names != (char *) NULL) {
+	FREE(d->names);
+    }
+    d->dir[0] = '\0';
+}
+
+/*
+ * NAME:	dir_cached()
+ * DESCRIPTION:	get the listing of a directory from the cache, reading and
+ *		caching it if needed; return NULL if the directory cannot be
+ *		watched for changes
+ */
+static dirinfo *dir_cached(char *dir)
+{
+    struct stat sbuf;
+    int i, wd;
+    Uint namesz;
+    dirinfo *d, *lru;
+
+    /*
+     * drop the listings of changed directories
+     */
+    while ((wd = P_dirchanged()) != -1) {
+	for (i = DIRCACHESZ, d = dircache; i > 0; --i, d++) {
+	    if (d->dir[0] != '\0' && (wd == DW_ALL || wd == d->wd)) {
+		dir_uncache(d);
+	    }
+	}
+    }
+
+    if (P_stat(dir, &sbuf) < 0 || (sbuf.st_mode & S_IFMT) != S_IFDIR) {
+	return (dirinfo *) NULL;
+    }
+    lru = dircache;
+    for (i = DIRCACHESZ, d = dircache; i > 0; --i, d++) {
+	if (d->dir[0] != '\0' && strcmp(d->dir, dir) == 0) {
+	    if (d->ino == sbuf.st_ino) {
+		d->stamp = ++dirstamp;
+		return d;
+	    }
+	    /* replaced by another directory */
+	    dir_uncache(d);
+	}
+	if (d->dir[0] == '\0' ||
+	    (lru->dir[0] != '\0' && d->stamp < lru->stamp)) {
+	    lru = d;
+	}
+    }
+
+    /*
+     * watch before reading, so no change can be missed
+     */
+    if (lru->dir[0] != '\0') {
+	dir_uncache(lru);
+    }
+    wd = P_watchdir(dir);
+    if (wd < 0) {
+	return (dirinfo *) NULL;
+    }
+    lru->wd = wd;
+    if (!dir_read(dir, (char *) NULL, lru, &namesz)) {
+	dir_uncache(lru);
+	return (dirinfo *) NULL;
+    }
+    strcpy(lru->dir, dir);
+    lru->ino = sbuf.st_ino;
+    lru->stamp = ++dirstamp;
+    return lru;
+}
+
+/*
+ * NAME:	kfun->purge_dirs()
+ * DESCRIPTION:	empty the directory listing cache, before dynamic memory
+ *		is purged
+ */
+void kf_purge_dirs()
+{
+    int i;
+    dirinfo *d;
+
+    for (i = DIRCACHESZ, d = dircache; i > 0; --i, d++) {
+	if (d->dir[0] != '\0') {
+	    dir_uncache(d);
+	}
+    }
+}
+
+/*
+ * NAME:	get_dir()
+ * DESCRIPTION:	get a slice of a directory filelist + info
+ */
+static int get_dir(frame *f, Int offset, Int count)
+{
+    Uint i, n;
+    fileinfo **ftable, *finf, single;
     char *file, *dir, *pat, buf[STRINGSZ], dirbuf[STRINGSZ];
-    fileinfo finf;
+    dirinfo *d, tmp;
     array *a;
+    value *v1, *v2, *v3;
 
     file = path_string(buf, f->sp->u.string->text, f->sp->u.string->len);
 
@@ -1559,70 +2191,138 @@ int kf_get_dir(frame *f)
 	*pat++ = '\0';
     }
 
-    ftable = ALLOC(fileinfo, ftabsz = FILEINFO_CHUNK);
-    nfiles = 0;
-    if (strpbrk(pat, "?*[\\") == (char *) NULL &&
-	getinfo(file, pat, &ftable[0])) {
+    d = (dirinfo *) NULL;
+    tmp.nfiles = 0;
+    tmp.files = (fileinfo *) NULL;
+    tmp.names = (char *) NULL;
+    if (strpbrk(pat, "?*[\\") == (char *) NULL && getinfo(file, &single)) {
 	/*
 	 * single file
 	 */
-	nfiles++;
-    } else if (strcmp(dir, ".") == 0 || P_chdir(dir) >= 0) {
-	if (P_opendir(".")) {
-	    /*
-	     * read files from directory
-	     */
-	    i = conf_array_size();
-	    while (nfiles < i && (file=P_readdir()) != (char *) NULL) {
-		if (match(pat, file) > 0 && getinfo(file, file, &finf)) {
-		    /* add file */
-		    if (nfiles == ftabsz) {
-			fileinfo *tmp;
-
-			tmp = ALLOC(fileinfo, ftabsz + FILEINFO_CHUNK);
-			memcpy(tmp, ftable, ftabsz * sizeof(fileinfo));
-			ftabsz += FILEINFO_CHUNK;
-			FREE(ftable);
-			ftable = tmp;
-		    }
-		    ftable[nfiles++] = finf;
-		}
-	    }
-	    P_closedir();
+	single.name = 0;
+	single.len = strlen(pat);
+	tmp.nfiles = 1;
+	tmp.files = &single;
+	tmp.names = pat;
+	d = &tmp;
+	pat = (char *) NULL;
+    } else {
+	d = dir_cached(dir);
+	if (d == (dirinfo *) NULL) {
+	    /* read only the matching files */
+	    dir_read(dir, pat, d = &tmp, &i);
+	    pat = (char *) NULL;
 	}
+    }
 
-	if (strcmp(dir, ".") != 0 &&
-	    P_chdir(path_native(buf, conf_base_dir())) < 0) {
-	    fatal("cannot chdir back to base dir");
+    /*
+     * select the requested slice of matching files
+     */
+    if (count == 0 || count > conf_array_size()) {
+	count = conf_array_size();
+    }
+    ftable = (d->nfiles != 0) ?
+	      ALLOC(fileinfo*, ((Uint) count < d->nfiles) ? count : d->nfiles) :
+	      (fileinfo **) NULL;
+    n = 0;
+    for (i = d->nfiles, finf = d->files; i > 0 && n < count; --i, finf++) {
+	if (pat == (char *) NULL || match(pat, d->names + finf->name) > 0) {
+	    if (offset != 0) {
+		--offset;
+	    } else {
+		ftable[n++] = finf;
+	    }
 	}
     }
 
     /* prepare return value */
     str_del(f->sp->u.string);
     PUT_ARRVAL(f->sp, a = arr_new(f->data, 3L));
-    PUT_ARRVAL(&a->elts[0], arr_new(f->data, (long) nfiles));
-    PUT_ARRVAL(&a->elts[1], arr_new(f->data, (long) nfiles));
-    PUT_ARRVAL(&a->elts[2], arr_new(f->data, (long) nfiles));
+    PUT_ARRVAL(&a->elts[0], arr_new(f->data, (long) n));
+    PUT_ARRVAL(&a->elts[1], arr_new(f->data, (long) n));
+    PUT_ARRVAL(&a->elts[2], arr_new(f->data, (long) n));
+
+    i_add_ticks(f, 1000 + 5 * n);
+
+    v1 = a->elts[0].u.array->elts;
+    v2 = a->elts[1].u.array->elts;
+    v3 = a->elts[2].u.array->elts;
+    for (i = 0; i < n; i++) {
+	finf = ftable[i];
+	if (finf->size == -2 && d != &tmp &&
+	    strlen(dir) + finf->len + 2 <= STRINGSZ) {
+	    /*
+	     * changes inside a subdirectory are not seen by the watch on
+	     * this directory, so refresh its time
+	     */
+	    sprintf(buf, "%s/%s", dir, d->names + finf->name);
+	    getinfo(buf, finf);
+	}
+	PUT_STRVAL(v1, str_new(d->names + finf->name, (long) finf->len));
+	PUT_INTVAL(v2, finf->size);
+	PUT_INTVAL(v3, finf->time);
+	v1++, v2++, v3++;
+    }
+    if (ftable != (fileinfo **) NULL) {
+	FREE(ftable);
+    }
+    if (d == &tmp && tmp.files != &single) {
+	if (tmp.files != (fileinfo *) NULL) {
+	    FREE(tmp.files);
+	}
+	if (tmp.names != (char *) NULL) {
+	    FREE(tmp.names);
+	}
+    }
 
-    i_add_ticks(f, 1000 + 5 * nfiles);
+    return 0;
+}
 
-    if (nfiles != 0) {
-	value *n, *s, *t;
+char pt_old_get_dir[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
+			  T_MIXED | (2 << REFSHIFT), T_STRING };
 
-	qsort(ftable, nfiles, sizeof(fileinfo), cmp);
-	n = a->elts[0].u.array->elts;
-	s = a->elts[1].u.array->elts;
-	t = a->elts[2].u.array->elts;
-	for (i = nfiles; i > 0; --i, ftable++) {
-	    PUT_STRVAL_NOREF(n, ftable->name);
-	    PUT_INTVAL(s, ftable->size);
-	    PUT_INTVAL(t, ftable->time);
-	    n++, s++, t++;
-	}
-	ftable -= nfiles;
+/*
+ * NAME:	kfun->old_get_dir()
+ * DESCRIPTION:	get directory filelist + info
+ */
+int kf_old_get_dir(frame *f)
+{
+    return get_dir(f, 0, 0);
+}
+# endif
+
+
+# ifdef FUNCDEF
+FUNCDEF("get_dir", kf_get_dir, pt_get_dir, 1)
+# else
+char pt_get_dir[] = { C_TYPECHECKED | C_STATIC, 1, 2, 0, 9,
+		      T_MIXED | (2 << REFSHIFT), T_STRING, T_INT, T_INT };
+
+/*
+ * NAME:	kfun->get_dir()
+ * DESCRIPTION:	get directory filelist + info, optionally only the files
+ *		from a given offset in the sorted list, up to a given count
+ */
+int kf_get_dir(frame *f, int nargs)
+{
+    Int offset, count;
+
+    offset = count = 0;
+    switch (nargs) {
+    case 3:
+	count = (f->sp++)->u.number;
+	/* fall through */
+    case 2:
+	offset = (f->sp++)->u.number;
+	break;
+    }
+    if (offset < 0) {
+	return 2;
+    }
+    if (count < 0) {
+	return 3;
     }
-    FREE(ftable);
 
-    return 0;
+    return get_dir(f, offset, count);
 }
 # endif
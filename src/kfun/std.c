@@ -138,6 +138,84 @@ int kf_compile_object(frame *f, int nargs)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("compile_objects", kf_compile_objects, pt_compile_objects, 0)
+# else
+char pt_compile_objects[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
+			      T_MIXED | (1 << REFSHIFT),
+			      T_STRING | (1 << REFSHIFT) };
+
+/*
+ * NAME:	kfun->compile_objects()
+ * DESCRIPTION:	compile a batch of objects, returning the objects, the time
+ *		spent compiling each, and the total time, in microseconds
+ */
+int kf_compile_objects(frame *f)
+{
+    char file[STRINGSZ + 2];
+    array *a, *objs, *times;
+    value *v;
+    object *obj;
+    Uuint start, total;
+    Int i, n;
+
+    n = f->sp->u.array->size;
+    a = arr_ext_new(f->data, 3L);
+    PUSH_ARRVAL(f, a);
+    PUT_ARRVAL(&a->elts[0], objs = arr_ext_new(f->data, (long) n));
+    PUT_ARRVAL(&a->elts[1], times = arr_ext_new(f->data, (long) n));
+    PUT_INTVAL(&a->elts[2], 0);
+
+    /* check the names, and start reading all sources in the background */
+    for (i = 0, v = d_get_elts(f->sp[1].u.array); i < n; i++, v++) {
+	if (v->type != T_STRING ||
+	    path_string(file, v->u.string->text,
+			v->u.string->len) == (char *) NULL) {
+	    error("Bad argument 1 for kfun compile_objects");
+	}
+	strcat(file, ".c");
+	P_prefetch(file);
+    }
+
+    total = 0;
+    for (i = 0; i < n; i++) {
+	v = &d_get_elts(f->sp[1].u.array)[i];
+	if (v->type != T_STRING ||
+	    path_string(file, v->u.string->text,
+			v->u.string->len) == (char *) NULL) {
+	    error("Bad argument 1 for kfun compile_objects");
+	}
+	obj = o_find(file, OACC_MODIFY);
+	if (obj != (object *) NULL) {
+	    if (!(obj->flags & O_MASTER)) {
+		error("Cannot recompile cloned object");
+	    }
+	    if (O_UPGRADING(obj)) {
+		error("Object is already being upgraded");
+	    }
+	    if (O_INHERITED(obj)) {
+		error("Cannot recompile inherited object");
+	    }
+	}
+
+	start = P_utime();
+	obj = c_compile(f, file, obj, (string **) NULL, 0, FALSE);
+	start = P_utime() - start;
+	total += start;
+
+	PUT_OBJVAL(&objs->elts[i], obj);
+	PUT_INTVAL(&times->elts[i], (Int) start);
+    }
+    PUT_INTVAL(&a->elts[2], (Int) total);
+
+    arr_del(f->sp[1].u.array);
+    f->sp[1] = f->sp[0];
+    f->sp++;
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("call_other", kf_call_other, pt_call_other, 0)
 # else
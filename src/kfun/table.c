@@ -20,6 +20,7 @@
 # define INCLUDE_FILE_IO
 # include "kfun.h"
 # include "table.h"
+# include "parse.h"
 
 /*
  * prototypes
@@ -60,6 +61,7 @@ extern void kf_dec_key(frame *, int, value *);
 extern void kf_xcrypt(frame *, int, value *);
 extern void kf_md5(frame *, int, value *);
 extern void kf_sha1(frame *, int, value *);
+extern void kf_sha256(frame *, int, value *);
 
 /*
  * NAME:	kfun->clear()
@@ -75,12 +77,13 @@ void kf_clear()
 	{ "decrypt DES key", proto, kf_dec_key },
 	{ "hash MD5", proto, kf_md5 },
 	{ "hash SHA1", proto, kf_sha1 },
+	{ "hash SHA256", proto, kf_sha256 },
 	{ "hash crypt", proto, kf_xcrypt }
     };
 
     nkfun = sizeof(kforig) / sizeof(kfunc);
     ne = nd = nh = 0;
-    kf_ext_kfun(builtin, 7);
+    kf_ext_kfun(builtin, 8);
 }
 
 /*
@@ -390,6 +393,17 @@ typedef struct {
 
 static char dh_layout[] = "sss";
 
+/*
+ * NAME:	kfun->purge()
+ * DESCRIPTION:	empty kfun caches kept in dynamic memory
+ */
+void kf_purge()
+{
+    kf_purge_dirs();
+    kf_purge_regexp();
+    ps_purge();
+}
+
 /*
  * NAME:	kfun->dump()
  * DESCRIPTION:	dump the kfun table
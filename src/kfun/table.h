@@ -43,6 +43,9 @@ extern void kf_ext_kfun	(extkfunc*, int);
 extern void kf_init	(void);
 extern int  kf_func	(char*);
 extern void kf_reclaim	(void);
+extern void kf_purge	(void);
+extern void kf_purge_dirs	(void);
+extern void kf_purge_regexp	(void);
 extern bool kf_dump	(int);
 extern void kf_restore	(int, int);
 
@@ -24,6 +24,7 @@
 # include "token.h"
 # include "path.h"
 # include "ppcontrol.h"
+# include "ccache.h"
 
 /*
  * Get a token from a file, handling preprocessor control directives.
@@ -505,6 +506,7 @@ static void do_include()
 
 	/* first try the path direct */
 	include = path_include(buf, tk_filename(), file, &strs, &nstr);
+	cc_include(tk_filename(), file, include);
 	if (tk_include(include, strs, nstr)) {
 	    include_level++;
 	    return;
@@ -523,6 +525,7 @@ static void do_include()
 	strcat(path, "/");
 	strcat(path, file);
 	include = path_include(buf, tk_filename(), path, &strs, &nstr);
+	cc_include(tk_filename(), path, include);
 	if (tk_include(include, strs, nstr)) {
 	    include_level++;
 	    return;
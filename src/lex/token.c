@@ -25,6 +25,7 @@
 # include "special.h"
 # include "ppstr.h"
 # include "token.h"
+# include "ccache.h"
 
 /*
  * The functions for getting a (possibly preprocessed) token from the input
@@ -32,6 +33,7 @@
  */
 
 # define TCHUNKSZ	8
+# define ICACHESZ	64	/* # entries in include file cache */
 
 typedef struct _tbuf_ {
     string **strs;		/* input buffer array */
@@ -51,6 +53,13 @@ typedef struct _tbuf_ {
     struct _tbuf_ *prev;	/* previous token buffer */
 } tbuf;
 
+typedef struct {
+    char *file;			/* file name */
+    char *text;			/* file contents, in static memory */
+    off_t size;			/* file size */
+    time_t mtime;		/* file modification time */
+} icache;
+
 typedef struct _tchunk_ {
     struct _tchunk_ *next;	/* next in list */
     tbuf t[TCHUNKSZ];		/* chunk of token buffers */
@@ -71,6 +80,9 @@ static tbuf *ibuffer;		/* current input buffer */
 static int pp_level;		/* the recursive preprocesing level */
 static bool do_include;		/* treat < and strings specially */
 static bool seen_nl;		/* just seen a newline */
+static icache itab[ICACHESZ];	/* include file cache */
+static Uint nincluded;		/* # files included */
+static Uint ncached;		/* # included files taken from the cache */
 
 /*
  * NAME:	token->init()
@@ -87,6 +99,7 @@ void tk_init()
     ibuffer = (tbuf *) NULL;
     pp_level = 0;
     do_include = FALSE;
+    nincluded = ncached = 0;
 }
 
 /*
@@ -185,6 +198,72 @@ void tk_clear()
     }
 }
 
+/*
+ * NAME:	token->cached()
+ * DESCRIPTION:	get the contents of an include file from the cache, reading
+ *		it if the file is not cached or has changed since
+ */
+static string *tk_cached(char *file)
+{
+    struct stat sbuf;
+    icache *ic;
+    string *str;
+    int fd;
+
+    if (P_stat(file, &sbuf) < 0 || (sbuf.st_mode & S_IFMT) != S_IFREG ||
+	sbuf.st_size > MAX_STRLEN) {
+	return (string *) NULL;
+    }
+    ic = &itab[hashstr(file, STRINGSZ) % ICACHESZ];
+    if (ic->file != (char *) NULL && strcmp(ic->file, file) == 0 &&
+	ic->size == sbuf.st_size && ic->mtime == sbuf.st_mtime) {
+	ncached++;
+	return str_new(ic->text, (long) ic->size);
+    }
+
+    /* read the file */
+    fd = P_open(file, O_RDONLY | O_BINARY, 0);
+    if (fd < 0) {
+	return (string *) NULL;
+    }
+    str = str_new((char *) NULL, (long) sbuf.st_size);
+    if (P_read(fd, str->text, str->len) != str->len) {
+	P_close(fd);
+	str_ref(str);
+	str_del(str);
+	return (string *) NULL;
+    }
+    P_close(fd);
+
+    /*
+     * the cache is kept in static memory, so that it survives the purging
+     * of dynamic memory between threads
+     */
+    m_static();
+    if (ic->file != (char *) NULL) {
+	FREE(ic->text);
+	FREE(ic->file);
+    }
+    ic->file = strcpy(ALLOC(char, strlen(file) + 1), file);
+    ic->text = ALLOC(char, str->len + 1);
+    m_dynamic();
+    memcpy(ic->text, str->text, str->len);
+    ic->size = sbuf.st_size;
+    ic->mtime = sbuf.st_mtime;
+    return str;
+}
+
+/*
+ * NAME:	token->info()
+ * DESCRIPTION:	return the number of files included, and how many of those
+ *		came from the cache
+ */
+void tk_info(Uint *included, Uint *cached)
+{
+    *included = nincluded;
+    *cached = ncached;
+}
+
 /*
  * NAME:	token->include()
  * DESCRIPTION:	push a file on the input stream
@@ -193,14 +272,29 @@ bool tk_include(char *file, string **strs, int nstr)
 {
     int fd;
     ssizet len;
+    string *str;
 
     if (file != (char *) NULL) {
+	if (strs != (string **) NULL) {
+	    /* not read from a file */
+	    cc_depend((char *) NULL, (string *) NULL, TRUE);
+	} else if (tbuffer != (tbuf *) NULL) {
+	    /* from the include file cache */
+	    str = tk_cached(file);
+	    if (str != (string *) NULL) {
+		cc_depend(file, str, TRUE);
+		strs = ALLOC(string*, 1);
+		str_ref(*strs++ = str);
+		nstr = 1;
+	    }
+	}
 	if (strs == (string **) NULL) {
 	    struct stat sbuf;
 
 	    /* read from file */
 	    fd = P_open(file, O_RDONLY | O_BINARY, 0);
 	    if (fd < 0) {
+		cc_depend(file, (string *) NULL, FALSE);
 		return FALSE;
 	    }
 
@@ -208,8 +302,10 @@ bool tk_include(char *file, string **strs, int nstr)
 	    if ((sbuf.st_mode & S_IFMT) != S_IFREG) {
 		/* no source this */
 		P_close(fd);
+		cc_depend(file, (string *) NULL, FALSE);
 		return FALSE;
 	    }
+	    cc_depend(file, (string *) NULL, TRUE);
 
 	    push((macro *) NULL, ALLOC(char, BUF_SIZE), 0, TRUE);
 	} else {
@@ -233,6 +329,9 @@ bool tk_include(char *file, string **strs, int nstr)
 	ibuffer->u.filename[len + 1] = '\0';
 	ibuffer->line = 1;
 	seen_nl = TRUE;
+	if (ibuffer->prev != (tbuf *) NULL) {
+	    nincluded++;
+	}
 
 	return TRUE;
     }
@@ -19,6 +19,7 @@
 
 extern void		 tk_init	(void);
 extern void		 tk_clear	(void);
+extern void		 tk_info	(Uint*, Uint*);
 extern bool		 tk_include	(char*, string**, int);
 extern void		 tk_endinclude	(void);
 extern unsigned short	 tk_line	(void);
@@ -997,6 +997,25 @@ dataspace *o_dataspace(object *o)
     return o->data;
 }
 
+/*
+ * NAME:	object->datasize()
+ * DESCRIPTION:	get the memory and swap usage of the dataspace of an object,
+ *		without loading it; unknown until restored from a snapshot
+ */
+void o_datasize(object *o, long *strbytes, long *arrbytes, Uint *swapsize)
+{
+    if (o->data != (dataspace *) NULL) {
+	*strbytes = o->data->strbytes;
+	*arrbytes = o->data->arrbytes;
+	*swapsize = o->data->swapsize;
+    } else if (o->dfirst != SW_UNUSED && !BTST(omap, o->index)) {
+	d_get_datasize(o, strbytes, arrbytes, swapsize);
+    } else {
+	*strbytes = *arrbytes = 0;
+	*swapsize = 0;
+    }
+}
+
 /*
  * NAME:	object->clean_upgrades()
  * DESCRIPTION:	clean up upgrade templates
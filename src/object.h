@@ -85,6 +85,7 @@ extern char	 *o_builtin_name	(Int);
 extern object	 *o_find		(char*, int);
 extern control   *o_control		(object*);
 extern dataspace *o_dataspace		(object*);
+extern void	  o_datasize		(object*, long*, long*, Uint*);
 
 extern void	  o_clean		(void);
 extern uindex	  o_count		(void);
@@ -1543,6 +1543,39 @@ static dfastate *dfa_expand(dfa *fa, dfastate *state)
     return state;
 }
 
+/*
+ * NAME:	dfa->build()
+ * DESCRIPTION:	expand all states, one tick per state, until ticks run out;
+ *		return FALSE if the DFA has become too big
+ */
+bool dfa_build(dfa *fa, Int *ticks, unsigned short *nstates, Uint *size)
+{
+    dfastate *state;
+
+    for (state = &fa->states[1]; fa->nstates != fa->nexpanded + fa->endstates;
+	 state++) {
+	if (fa->nstates > USHRT_MAX - 256 ||
+	    fa->dfasize > (Uint) MAX_AUTOMSZ * USHRT_MAX) {
+	    return FALSE;
+	}
+	if (state->ntrans == 0) {
+	    if (*ticks < 0) {
+		break;	/* continue later */
+	    }
+	    state = dfa_expand(fa, state);
+	    --*ticks;
+	}
+    }
+    if (fa->nstates > USHRT_MAX - 256 ||
+	fa->dfasize > (Uint) MAX_AUTOMSZ * USHRT_MAX) {
+	return FALSE;
+    }
+
+    *nstates = fa->nstates;
+    *size = fa->dfasize;
+    return TRUE;
+}
+
 /*
  * NAME:	dfa->scan()
  * DESCRIPTION:	Scan input, while lazily constructing a DFA.
@@ -27,4 +27,5 @@ extern dfa     *dfa_new		(char*, char*);
 extern void	dfa_del		(dfa*);
 extern dfa     *dfa_load	(char*, char*, char*, Uint);
 extern bool	dfa_save	(dfa*, char**, Uint*);
+extern bool	dfa_build	(dfa*, Int*, unsigned short*, Uint*);
 extern short	dfa_scan	(dfa*, string*, ssizet*, char**, ssizet*);
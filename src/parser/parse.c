@@ -19,6 +19,7 @@
 
 # define INCLUDE_CTYPE
 # include "dgd.h"
+# include "hash.h"
 # include "str.h"
 # include "array.h"
 # include "object.h"
@@ -44,6 +45,7 @@ typedef struct _pnode_ {
 } pnode;
 
 # define PNCHUNKSZ	256
+# define PNRETAIN	32	/* max # of retained pnode chunks */
 
 typedef struct _pnchunk_ {
     int chunksz;		/* size of this chunk */
@@ -51,6 +53,9 @@ typedef struct _pnchunk_ {
     pnode pn[PNCHUNKSZ];	/* chunk of pnodes */
 } pnchunk;
 
+static pnchunk *pnfree;		/* retained pnode chunks */
+static int npnfree;		/* # of retained pnode chunks */
+
 /*
  * NAME:	pnode->new()
  * DESCRIPTION:	create a new pnode
@@ -62,7 +67,14 @@ static pnode *pn_new(pnchunk **c, short symb, unsigned short state, char *text,
     if (*c == (pnchunk *) NULL || (*c)->chunksz == PNCHUNKSZ) {
 	pnchunk *x;
 
-	x = ALLOC(pnchunk, 1);
+	if (pnfree != (pnchunk *) NULL) {
+	    /* reuse a chunk released by an earlier parse */
+	    x = pnfree;
+	    pnfree = x->next;
+	    --npnfree;
+	} else {
+	    x = ALLOC(pnchunk, 1);
+	}
 	x->next = *c;
 	*c = x;
 	x->chunksz = 0;
@@ -81,7 +93,8 @@ static pnode *pn_new(pnchunk **c, short symb, unsigned short state, char *text,
 
 /*
  * NAME:	pnode->clear()
- * DESCRIPTION:	free all pnodes in memory
+ * DESCRIPTION:	release all pnodes at once, retaining some chunks for
+ *		the next parse
  */
 static void pn_clear(pnchunk *c)
 {
@@ -90,7 +103,13 @@ static void pn_clear(pnchunk *c)
     while (c != (pnchunk *) NULL) {
 	f = c;
 	c = c->next;
-	FREE(f);
+	if (npnfree < PNRETAIN) {
+	    f->next = pnfree;
+	    pnfree = f;
+	    npnfree++;
+	} else {
+	    FREE(f);
+	}
     }
 }
 
@@ -98,9 +117,11 @@ typedef struct _snode_ {
     pnode *pn;			/* pnode */
     struct _snode_ *next;	/* next to be treated */
     struct _snode_ *slist;	/* per-state list */
+    struct _snode_ *hlist;	/* per-hash list */
 } snode;
 
 # define SNCHUNKSZ	32
+# define SNRETAIN	32	/* max # of retained snode chunks */
 
 typedef struct _snchunk_ {
     int chunksz;		/* size of this chunk */
@@ -108,6 +129,17 @@ typedef struct _snchunk_ {
     snode sn[SNCHUNKSZ];	/* chunk of snodes */
 } snchunk;
 
+static snchunk *snfree;		/* retained snode chunks */
+static int nsnfree;		/* # of retained snode chunks */
+
+# define SNTABSZ	1024	/* reduction hash table size */
+# define SNHASH(state, symb, next) \
+	((((uintptr_t) (next) / sizeof(pnode)) * 31 + (state) * 7 + (symb)) & \
+	 (SNTABSZ - 1))
+
+static snode *sntab[SNTABSZ];	/* reductions, hashed by state, symbol and
+				   predecessor */
+
 typedef struct {
     snchunk *snc;		/* snode chunk */
     snode *first;		/* first node in list */
@@ -130,7 +162,13 @@ static snode *sn_new(snlist *list, pnode *pn, snode *slist)
 	if (list->snc == (snchunk *) NULL || list->snc->chunksz == SNCHUNKSZ) {
 	    snchunk *x;
 
-	    x = ALLOC(snchunk, 1);
+	    if (snfree != (snchunk *) NULL) {
+		x = snfree;
+		snfree = x->next;
+		--nsnfree;
+	    } else {
+		x = ALLOC(snchunk, 1);
+	    }
 	    x->next = list->snc;
 	    list->snc = x;
 	    x->chunksz = 0;
@@ -183,7 +221,8 @@ static void sn_del(snlist *list, snode *sn)
 
 /*
  * NAME:	snode->clear()
- * DESCRIPTION:	free all snodes in memory
+ * DESCRIPTION:	release all snodes at once, retaining some chunks for
+ *		the next parse
  */
 static void sn_clear(snlist *list)
 {
@@ -193,7 +232,13 @@ static void sn_clear(snlist *list)
     while (c != (snchunk *) NULL) {
 	f = c;
 	c = c->next;
-	FREE(f);
+	if (nsnfree < SNRETAIN) {
+	    f->next = snfree;
+	    snfree = f;
+	    nsnfree++;
+	} else {
+	    FREE(f);
+	}
     }
     list->snc = (snchunk *) NULL;
     list->first = list->free = (snode *) NULL;
@@ -292,10 +337,7 @@ static void ac_clean(arrchunk *c)
 }
 
 
-struct _parser_ {
-    frame *frame;		/* interpreter stack frame */
-    dataspace *data;		/* dataspace for current object */
-
+typedef struct _psgram_ {
     string *source;		/* grammar source */
     string *grammar;		/* preprocessed grammar */
     char *fastr;		/* DFA string */
@@ -306,6 +348,176 @@ struct _parser_ {
     short ntoken;		/* # of tokens (regexp + string) */
     short nprod;		/* # of nonterminals */
 
+    unsigned short fasize;	/* # of saved DFA strings */
+    unsigned short lrsize;	/* # of saved SRP strings */
+    string **fasave;		/* saved DFA strings */
+    string **lrsave;		/* saved SRP strings */
+    Uint version;		/* saved strings version */
+
+    Uint ref;			/* # of parsers using this grammar */
+    struct _psgram_ *next;	/* next in hash chain */
+} psgram;
+
+# define GRAMTABSZ	64	/* grammar hash table size */
+
+static psgram *gramtab[GRAMTABSZ];	/* shared grammars */
+
+/*
+ * NAME:	psgram->new()
+ * DESCRIPTION:	create a new shared grammar
+ */
+static psgram *pg_new(string *source, string *grammar)
+{
+    psgram *pg, **h;
+    char *p;
+
+    pg = ALLOC(psgram, 1);
+    str_ref(pg->source = source);
+    str_ref(pg->grammar = grammar);
+    pg->fastr = (char *) NULL;
+    pg->lrstr = (char *) NULL;
+    pg->fa = (dfa *) NULL;
+    pg->lr = (srp *) NULL;
+
+    p = grammar->text;
+    pg->ntoken = ((UCHAR(p[5]) + UCHAR(p[9]) + UCHAR(p[11])) << 8) +
+		 UCHAR(p[6]) + UCHAR(p[10]) + UCHAR(p[12]);
+    pg->nprod = (UCHAR(p[13]) << 8) + UCHAR(p[14]);
+
+    pg->fasize = pg->lrsize = 0;
+    pg->fasave = pg->lrsave = (string **) NULL;
+    pg->version = 0;
+
+    pg->ref = 0;
+    h = &gramtab[hashmem(source->text, source->len) % GRAMTABSZ];
+    pg->next = *h;
+    *h = pg;
+
+    return pg;
+}
+
+/*
+ * NAME:	psgram->find()
+ * DESCRIPTION:	find a shared grammar for the given source
+ */
+static psgram *pg_find(string *source)
+{
+    psgram *pg;
+
+    for (pg = gramtab[hashmem(source->text, source->len) % GRAMTABSZ];
+	 pg != (psgram *) NULL; pg = pg->next) {
+	if (pg->source == source || str_cmp(pg->source, source) == 0) {
+	    return pg;
+	}
+    }
+    return (psgram *) NULL;
+}
+
+/*
+ * NAME:	psgram->load()
+ * DESCRIPTION:	collect the saved strings of an automaton
+ */
+static char *pg_load(value *elts, unsigned short size, string ***save,
+		     char **str, Uint *len)
+{
+    char *p;
+    unsigned short i;
+
+    *save = ALLOC(string*, size);
+    for (i = 0; i < size; i++) {
+	str_ref((*save)[i] = elts[i].u.string);
+    }
+
+    if (size > 1) {
+	for (i = size, *len = 0; i != 0; ) {
+	    *len += elts[--i].u.string->len;
+	}
+	p = *str = ALLOC(char, *len);
+	for (i = 0; i < size; i++) {
+	    memcpy(p, elts[i].u.string->text, elts[i].u.string->len);
+	    p += elts[i].u.string->len;
+	}
+	return *str;
+    } else {
+	*len = elts->u.string->len;
+	return elts->u.string->text;
+    }
+}
+
+/*
+ * NAME:	psgram->save()
+ * DESCRIPTION:	save an automaton as strings
+ */
+static unsigned short pg_save(char *str, Uint len, string ***save)
+{
+    unsigned short size, i;
+    Uint n;
+
+    size = 1 + (len - 1) / USHRT_MAX;
+    *save = ALLOC(string*, size);
+    for (i = 0; i < size; i++) {
+	n = (len > USHRT_MAX) ? USHRT_MAX : len;
+	str_ref((*save)[i] = str_new(str, (long) n));
+	str += n;
+	len -= n;
+    }
+    return size;
+}
+
+/*
+ * NAME:	psgram->clear()
+ * DESCRIPTION:	remove saved strings
+ */
+static void pg_clear(string **save, unsigned short size)
+{
+    if (save != (string **) NULL) {
+	while (size != 0) {
+	    str_del(save[--size]);
+	}
+	FREE(save);
+    }
+}
+
+/*
+ * NAME:	psgram->del()
+ * DESCRIPTION:	remove a reference to a shared grammar, deleting it if
+ *		it was the last one
+ */
+static void pg_del(psgram *pg)
+{
+    psgram **p;
+
+    if (--pg->ref != 0) {
+	return;
+    }
+
+    for (p = &gramtab[hashmem(pg->source->text, pg->source->len) % GRAMTABSZ];
+	 *p != pg; p = &(*p)->next) ;
+    *p = pg->next;
+
+    dfa_del(pg->fa);
+    srp_del(pg->lr);
+    if (pg->fastr != (char *) NULL) {
+	FREE(pg->fastr);
+    }
+    if (pg->lrstr != (char *) NULL) {
+	FREE(pg->lrstr);
+    }
+    pg_clear(pg->fasave, pg->fasize);
+    pg_clear(pg->lrsave, pg->lrsize);
+    str_del(pg->source);
+    str_del(pg->grammar);
+    FREE(pg);
+}
+
+
+struct _parser_ {
+    frame *frame;		/* interpreter stack frame */
+    dataspace *data;		/* dataspace for current object */
+
+    psgram *gram;		/* shared grammar */
+    Uint version;		/* version of grammar saved in object */
+
     pnchunk *pnc;		/* pnode chunk */
 
     unsigned short nstates;	/* state table size */
@@ -322,21 +534,17 @@ struct _parser_ {
  * NAME:	parser->new()
  * DESCRIPTION:	create a new parser instance
  */
-static parser *ps_new(frame *f, string *source, string *grammar)
+static parser *ps_new(frame *f, psgram *gram, Uint version)
 {
     parser *ps;
-    char *p;
 
     ps = ALLOC(parser, 1);
     ps->frame = f;
     ps->data = f->data;
     ps->data->parser = ps;
-    str_ref(ps->source = source);
-    str_ref(ps->grammar = grammar);
-    ps->fastr = (char *) NULL;
-    ps->lrstr = (char *) NULL;
-    ps->fa = dfa_new(source->text, grammar->text);
-    ps->lr = srp_new(grammar->text);
+    ps->gram = gram;
+    gram->ref++;
+    ps->version = version;
 
     ps->pnc = (pnchunk *) NULL;
     ps->list.snc = (snchunk *) NULL;
@@ -345,11 +553,6 @@ static parser *ps_new(frame *f, string *source, string *grammar)
     ps->strc = (strchunk *) NULL;
     ps->arrc = (arrchunk *) NULL;
 
-    p = grammar->text;
-    ps->ntoken = ((UCHAR(p[5]) + UCHAR(p[9]) + UCHAR(p[11])) << 8) +
-		 UCHAR(p[6]) + UCHAR(p[10]) + UCHAR(p[12]);
-    ps->nprod = (UCHAR(p[13]) << 8) + UCHAR(p[14]);
-
     return ps;
 }
 
@@ -360,16 +563,7 @@ static parser *ps_new(frame *f, string *source, string *grammar)
 void ps_del(parser *ps)
 {
     ps->data->parser = (parser *) NULL;
-    str_del(ps->source);
-    str_del(ps->grammar);
-    if (ps->fastr != (char *) NULL) {
-	FREE(ps->fastr);
-    }
-    if (ps->lrstr != (char *) NULL) {
-	FREE(ps->lrstr);
-    }
-    dfa_del(ps->fa);
-    srp_del(ps->lr);
+    pg_del(ps->gram);
     FREE(ps);
 }
 
@@ -379,7 +573,7 @@ void ps_del(parser *ps)
  */
 static void ps_reduce(parser *ps, pnode *pn, char *p)
 {
-    snode *sn;
+    snode *sn, **h;
     pnode *next;
     unsigned short n;
     short symb;
@@ -389,7 +583,7 @@ static void ps_reduce(parser *ps, pnode *pn, char *p)
     /*
      * get rule to reduce by
      */
-    red = ps->grammar->text + (UCHAR(p[0]) << 8) + UCHAR(p[1]);
+    red = ps->gram->grammar->text + (UCHAR(p[0]) << 8) + UCHAR(p[1]);
     p += 2;
     symb = (UCHAR(p[0]) << 8) + UCHAR(p[1]);
     len = UCHAR(red[0]);
@@ -406,15 +600,17 @@ static void ps_reduce(parser *ps, pnode *pn, char *p)
 	    next = next->next;
 	} while (--n != 0);
     }
-    n = srp_goto(ps->lr, next->state, symb);
+    n = srp_goto(ps->gram->lr, next->state, symb);
     pn = pn_new(&ps->pnc, symb, n, red, len, next, pn);
 
     /*
      * see if this reduction can be merged with another
      */
     i_add_ticks(ps->frame, 2);
-    for (sn = ps->states[n]; sn != (snode *) NULL; sn = sn->slist) {
-	if (sn->pn->symbol == symb && sn->pn->next == next) {
+    h = &sntab[SNHASH(n, symb, next)];
+    for (sn = *h; sn != (snode *) NULL; sn = sn->hlist) {
+	if (sn->pn->symbol == symb && sn->pn->next == next &&
+	    sn->pn->state == n) {
 	    pnode **ppn;
 
 	    if (sn->pn->u.text != (char *) NULL) {
@@ -442,7 +638,9 @@ static void ps_reduce(parser *ps, pnode *pn, char *p)
     /*
      * new reduction
      */
-    ps->states[n] = sn_new(&ps->list, pn, ps->states[n]);
+    sn = ps->states[n] = sn_new(&ps->list, pn, ps->states[n]);
+    sn->hlist = *h;
+    *h = sn;
 }
 
 /*
@@ -453,7 +651,7 @@ static void ps_shift(parser *ps, snode *sn, short token, char *text, ssizet len)
 {
     int n;
 
-    n = srp_shift(ps->lr, sn->pn->state, token);
+    n = srp_shift(ps->gram->lr, sn->pn->state, token);
     if (n >= 0) {
 	/* shift works: add new snode */
 	ps->states[n] = sn_add(&ps->list, sn,
@@ -483,12 +681,13 @@ static pnode *ps_parse(parser *ps, string *str, bool *toobig)
 
     /* initialize */
     size = str->len;
-    ps->nstates = srp_check(ps->lr, 0, &nred, &red);
-    if (ps->nstates < ps->nprod) {
-	ps->nstates = ps->nprod;
+    ps->nstates = srp_check(ps->gram->lr, 0, &nred, &red);
+    if (ps->nstates < ps->gram->nprod) {
+	ps->nstates = ps->gram->nprod;
     }
     ps->states = ALLOC(snode*, ps->nstates);
     memset(ps->states, '\0', ps->nstates * sizeof(snode*));
+    memset(sntab, '\0', SNTABSZ * sizeof(snode*));
     ps->list.first = (snode *) NULL;
 
     /* state 0 */
@@ -502,7 +701,7 @@ static pnode *ps_parse(parser *ps, string *str, bool *toobig)
 	 * apply reductions for current states, expanding states if needed
 	 */
 	for (sn = ps->list.first; sn != (snode *) NULL; sn = sn->next) {
-	    n = srp_check(ps->lr, sn->pn->state, &nred, &red);
+	    n = srp_check(ps->gram->lr, sn->pn->state, &nred, &red);
 	    if (n < 0) {
 		/* parser grown to big */
 		FREE(ps->states);
@@ -535,7 +734,7 @@ static pnode *ps_parse(parser *ps, string *str, bool *toobig)
 	    i_add_ticks(ps->frame, 1);
 	}
 
-	switch (n = dfa_scan(ps->fa, str, &size, &ttext, &tlen)) {
+	switch (n = dfa_scan(ps->gram->fa, str, &size, &ttext, &tlen)) {
 	case DFA_EOS:
 	    /* if end of string, return node from state 1 */
 	    sn = ps->states[1];
@@ -560,6 +759,8 @@ static pnode *ps_parse(parser *ps, string *str, bool *toobig)
 	    ps->list.first = (snode *) NULL;
 	    do {
 		next = sn->next;
+		sntab[SNHASH(sn->pn->state, sn->pn->symbol, sn->pn->next)] =
+							    (snode *) NULL;
 		ps_shift(ps, sn, n, ttext, tlen);
 		sn = next;
 	    } while (sn != (snode *) NULL);
@@ -635,7 +836,7 @@ static Int ps_traverse(parser *ps, pnode *pn, pnode *next)
 	/*
 	 * node hasn't been traversed before
 	 */
-	if (pn->symbol < ps->ntoken) {
+	if (pn->symbol < ps->gram->ntoken) {
 	    /*
 	     * token
 	     */
@@ -797,68 +998,27 @@ static Int ps_traverse(parser *ps, pnode *pn, pnode *next)
  */
 static parser *ps_load(frame *f, value *elts)
 {
-    parser *ps;
+    psgram *pg;
     char *p;
-    short i;
     Uint len;
-    short fasize, lrsize;
+    unsigned short fasize, lrsize;
 
-    ps = ALLOC(parser, 1);
-    ps->frame = f;
-    ps->data = f->data;
-    ps->data->parser = ps;
     fasize = elts->u.number >> 16;
     lrsize = (elts++)->u.number & 0xffff;
-    str_ref(ps->source = (elts++)->u.string);
-    str_ref(ps->grammar = (elts++)->u.string);
-
-    if (fasize > 1) {
-	for (i = fasize, len = 0; --i >= 0; ) {
-	    len += elts[i].u.string->len;
-	}
-	p = ps->fastr = ALLOC(char, len);
-	for (i = fasize; --i >= 0; ) {
-	    memcpy(p, elts->u.string->text, elts->u.string->len);
-	    p += (elts++)->u.string->len;
-	}
-	p -= len;
-    } else {
-	p = elts->u.string->text;
-	len = (elts++)->u.string->len;
-	ps->fastr = (char *) NULL;
-    }
-    ps->fa = dfa_load(ps->source->text, ps->grammar->text, p, len);
-
-    if (lrsize > 1) {
-	for (i = lrsize, len = 0; --i >= 0; ) {
-	    len += elts[i].u.string->len;
-	}
-	p = ps->lrstr = ALLOC(char, len);
-	for (i = lrsize; --i >= 0; ) {
-	    memcpy(p, elts->u.string->text, elts->u.string->len);
-	    p += (elts++)->u.string->len;
-	}
-	p -= len;
-    } else {
-	p = elts->u.string->text;
-	len = elts->u.string->len;
-	ps->lrstr = (char *) NULL;
-    }
-    ps->lr = srp_load(ps->grammar->text, p, len);
-
-    ps->pnc = (pnchunk *) NULL;
-    ps->list.snc = (snchunk *) NULL;
-    ps->list.first = ps->list.free = (snode *) NULL;
+    pg = pg_new(elts[0].u.string, elts[1].u.string);
+    elts += 2;
 
-    ps->strc = (strchunk *) NULL;
-    ps->arrc = (arrchunk *) NULL;
+    p = pg_load(elts, fasize, &pg->fasave, &pg->fastr, &len);
+    pg->fasize = fasize;
+    pg->fa = dfa_load(pg->source->text, pg->grammar->text, p, len);
+    elts += fasize;
 
-    p = ps->grammar->text;
-    ps->ntoken = ((UCHAR(p[5]) + UCHAR(p[9])) << 8) + UCHAR(p[6]) +
-		 UCHAR(p[10]);
-    ps->nprod = (UCHAR(p[11]) << 8) + UCHAR(p[12]);
+    p = pg_load(elts, lrsize, &pg->lrsave, &pg->lrstr, &len);
+    pg->lrsize = lrsize;
+    pg->lr = srp_load(pg->grammar->text, p, len);
 
-    return ps;
+    pg->version = 1;
+    return ps_new(f, pg, pg->version);
 }
 
 /*
@@ -867,62 +1027,110 @@ static parser *ps_load(frame *f, value *elts)
  */
 void ps_save(parser *ps)
 {
+    psgram *pg;
     value *v;
-    dataspace *data;
-    Uint len;
+    unsigned short i;
     value val;
-    short fasize, lrsize;
     char *fastr, *lrstr;
     Uint falen, lrlen;
-    bool save;
+    string **save;
+
+    pg = ps->gram;
 
-    save = dfa_save(ps->fa, &fastr, &falen) | srp_save(ps->lr, &lrstr, &lrlen);
+    /* dfa */
+    if (dfa_save(pg->fa, &fastr, &falen)) {
+	if (pg->fastr != (char *) NULL && fastr != pg->fastr) {
+	    FREE(pg->fastr);
+	    pg->fastr = (char *) NULL;
+	}
+	i = pg_save(fastr, falen, &save);
+	pg_clear(pg->fasave, pg->fasize);
+	pg->fasave = save;
+	pg->fasize = i;
+	pg->version++;
+    }
 
-    if (save) {
-	data = ps->data;
-	fasize = 1 + (falen - 1) / USHRT_MAX;
-	lrsize = 1 + (lrlen - 1) / USHRT_MAX;
-	PUT_ARRVAL_NOREF(&val, arr_new(data, 3L + fasize + lrsize));
+    /* srp */
+    if (srp_save(pg->lr, &lrstr, &lrlen)) {
+	if (pg->lrstr != (char *) NULL && lrstr != pg->lrstr) {
+	    FREE(pg->lrstr);
+	    pg->lrstr = (char *) NULL;
+	}
+	i = pg_save(lrstr, lrlen, &save);
+	pg_clear(pg->lrsave, pg->lrsize);
+	pg->lrsave = save;
+	pg->lrsize = i;
+	pg->version++;
+    }
 
-	/* grammar */
+    if (ps->version != pg->version) {
+	/*
+	 * the object refers to the strings shared by all users of the grammar
+	 */
+	PUT_ARRVAL_NOREF(&val, arr_new(ps->data,
+				       3L + pg->fasize + pg->lrsize));
 	v = val.u.array->elts;
-	PUT_INTVAL(v, ((Int) fasize << 16) + lrsize);
+	PUT_INTVAL(v, ((Int) pg->fasize << 16) + pg->lrsize);
 	v++;
-	PUT_STRVAL(v, ps->source);
+	PUT_STRVAL(v, pg->source);
 	v++;
-	PUT_STRVAL(v, ps->grammar);
+	PUT_STRVAL(v, pg->grammar);
 	v++;
-
-	/* dfa */
-	if (ps->fastr != (char *) NULL && fastr != ps->fastr) {
-	    FREE(ps->fastr);
-	    ps->fastr = (char *) NULL;
-	}
-	do {
-	    len = (falen > USHRT_MAX) ? USHRT_MAX : falen;
-	    PUT_STRVAL(v, str_new(fastr, (long) len));
+	for (i = 0; i < pg->fasize; i++) {
+	    PUT_STRVAL(v, pg->fasave[i]);
 	    v++;
-	    fastr += len;
-	    falen -= len;
-	} while (falen != 0);
-
-	/* srp */
-	if (ps->lrstr != (char *) NULL && lrstr != ps->lrstr) {
-	    FREE(ps->lrstr);
-	    ps->lrstr = (char *) NULL;
 	}
-	do {
-	    len = (lrlen > USHRT_MAX) ? USHRT_MAX : lrlen;
-	    PUT_STRVAL(v, str_new(lrstr, (long) len));
+	for (i = 0; i < pg->lrsize; i++) {
+	    PUT_STRVAL(v, pg->lrsave[i]);
 	    v++;
-	    lrstr += len;
-	    lrlen -= len;
-	} while (lrlen != 0);
+	}
 
-	d_set_extravar(data, &val);
+	d_set_extravar(ps->data, &val);
+	ps->version = pg->version;
     }
 }
 
+/*
+ * NAME:	parser->get()
+ * DESCRIPTION:	get a parser for the given grammar source
+ */
+static parser *ps_get(frame *f, string *source)
+{
+    dataspace *data;
+    parser *ps;
+    psgram *pg;
+    value *val;
+
+    data = f->data;
+    if (data->parser != (parser *) NULL) {
+	ps = data->parser;
+	ps->frame = f;
+	if (str_cmp(ps->gram->source, source) == 0) {
+	    return ps;
+	}
+	ps_del(ps);
+    }
+
+    pg = pg_find(source);
+    if (pg != (psgram *) NULL) {
+	/* share grammar with other objects */
+	return ps_new(f, pg, 0);
+    }
+
+    val = d_get_extravar(data);
+    if (val->type == T_ARRAY && d_get_elts(val->u.array)->type == T_INT &&
+	str_cmp(val->u.array->elts[1].u.string, source) == 0 &&
+	val->u.array->elts[2].u.string->text[0] == GRAM_VERSION) {
+	return ps_load(f, val->u.array->elts);
+    }
+
+    /* new grammar */
+    pg = pg_new(source, parse_grammar(source));
+    pg->fa = dfa_new(pg->source->text, pg->grammar->text);
+    pg->lr = srp_new(pg->grammar->text);
+    return ps_new(f, pg, 0);
+}
+
 /*
  * NAME:	parse_string()
  * DESCRIPTION:	parse a string
@@ -931,8 +1139,7 @@ array *ps_parse_string(frame *f, string *source, string *str, Int maxalt)
 {
     dataspace *data;
     parser *ps;
-    value *val;
-    bool same, toobig;
+    bool toobig;
     pnode *pn;
     array *a;
     Int len;
@@ -941,29 +1148,7 @@ array *ps_parse_string(frame *f, string *source, string *str, Int maxalt)
      * create or load parser
      */
     data = f->data;
-    if (data->parser != (parser *) NULL) {
-	ps = data->parser;
-	ps->frame = f;
-	same = (str_cmp(ps->source, source) == 0);
-    } else {
-	val = d_get_extravar(data);
-	if (val->type == T_ARRAY && d_get_elts(val->u.array)->type == T_INT &&
-	    str_cmp(val->u.array->elts[1].u.string, source) == 0 &&
-	    val->u.array->elts[2].u.string->text[0] == GRAM_VERSION) {
-	    ps = ps_load(f, val->u.array->elts);
-	    same = TRUE;
-	} else {
-	    ps = (parser *) NULL;
-	    same = FALSE;
-	}
-    }
-    if (!same) {
-	/* new parser */
-	if (ps != (parser *) NULL) {
-	    ps_del(ps);
-	}
-	ps = ps_new(f, source, parse_grammar(source));
-    }
+    ps = ps_get(f, source);
 
     /*
      * parse string
@@ -1033,3 +1218,81 @@ array *ps_parse_string(frame *f, string *source, string *str, Int maxalt)
 
     return NULL;
 }
+
+/*
+ * NAME:	build_grammar()
+ * DESCRIPTION:	fully construct the automata for a grammar, and return
+ *		their sizes and the construction time
+ */
+array *ps_build_grammar(frame *f, string *source)
+{
+    parser *ps;
+    psgram *pg;
+    Uuint time;
+    unsigned short fastates, lrstates;
+    Uint fasize, lrsize;
+    array *a;
+    value *v;
+
+    ps = ps_get(f, source);
+    pg = ps->gram;
+    i_add_ticks(f, 400);
+
+    time = P_utime();
+    for (;;) {
+	if (f->rlim->ticks >= 0 &&
+	    (!dfa_build(pg->fa, &f->rlim->ticks, &fastates, &fasize) ||
+	     !srp_build(pg->lr, &f->rlim->ticks, &lrstates, &lrsize))) {
+	    if (pg->ref == 1) {
+		ps_del(ps);
+	    }
+	    error("Grammar too large");
+	}
+	if (f->rlim->ticks >= 0) {
+	    break;
+	}
+	if (f->rlim->noticks) {
+	    f->rlim->ticks = 0x7fffffff;
+	} else {
+	    error("Out of ticks");
+	}
+    }
+    time = P_utime() - time;
+
+    a = arr_new(f->data, 5L);
+    v = a->elts;
+    PUT_INTVAL(v, fastates);
+    v++;
+    PUT_INTVAL(v, fasize);
+    v++;
+    PUT_INTVAL(v, lrstates);
+    v++;
+    PUT_INTVAL(v, lrsize);
+    v++;
+    PUT_INTVAL(v, (time > 0x7fffffff) ? 0x7fffffff : (Int) time);
+
+    return a;
+}
+
+/*
+ * NAME:	parser->purge()
+ * DESCRIPTION:	free retained pnode and snode chunks
+ */
+void ps_purge()
+{
+    pnchunk *pc;
+    snchunk *sc;
+
+    while (pnfree != (pnchunk *) NULL) {
+	pc = pnfree;
+	pnfree = pc->next;
+	FREE(pc);
+    }
+    npnfree = 0;
+    while (snfree != (snchunk *) NULL) {
+	sc = snfree;
+	snfree = sc->next;
+	FREE(sc);
+    }
+    nsnfree = 0;
+}
@@ -22,3 +22,5 @@ typedef struct _parser_ parser;
 extern void	ps_del		(parser*);
 extern array   *ps_parse_string	(frame*, string*, string*, Int);
 extern void	ps_save		(parser*);
+extern array   *ps_build_grammar(frame*, string*);
+extern void	ps_purge	(void);
@@ -0,0 +1,1069 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+# include "dgd.h"
+# include "rgx.h"
+
+/*
+ * Regular expressions for the regexp kfuns.  The syntax is that of
+ * parse_string() token rules, with anchors and subexpressions added:
+ *
+ *	c		the character c
+ *	\c		the character c, even if it is special
+ *	.		any character
+ *	[set]		any character in set, [^set] any character not in set
+ *	^  $		the start or the end of the string
+ *	(rgx)		subexpression; the first 9 are captured
+ *	rgx* rgx+ rgx?	zero or more, one or more, zero or one, preferring
+ *			more; followed by ? to prefer fewer
+ *	rgx|rgx		alternatives, preferring the leftmost
+ *
+ * A regular expression is compiled into a program for a Thompson NFA.
+ * Searching first runs a DFA, lazily constructed from the program, to
+ * find out if there is a match at all.  Only then is the NFA simulated
+ * with all threads in lockstep to find the subexpressions.  Either way,
+ * matching takes time linear in the length of the string.
+ */
+
+# define RN_CHAR	0	/* single character */
+# define RN_ANY		1	/* any character */
+# define RN_CLASS	2	/* character class */
+# define RN_BOL		3	/* start of string */
+# define RN_EOL		4	/* end of string */
+# define RN_GROUP	5	/* (rgx) */
+# define RN_ALT		6	/* rgx|rgx */
+# define RN_BRANCH	7	/* alternative */
+# define RN_STAR	8	/* rgx* */
+# define RN_PLUS	9	/* rgx+ */
+# define RN_QUEST	10	/* rgx? */
+
+# define RN_NONE	0xffff	/* no node */
+
+typedef struct {
+    char type;			/* node type */
+    bool lazy;			/* prefer fewer repetitions */
+    unsigned short arg;		/* character, class or subexpression */
+    unsigned short sub;		/* subexpression */
+    unsigned short next;	/* next node in sequence */
+} rgxnode;
+
+# define RGX_MAXDEPTH	64	/* max nesting depth */
+# define RGX_MAXLEN	1024	/* max length of regular expression */
+
+typedef struct {
+    char *p;			/* current position in pattern */
+    char *end;			/* end of pattern */
+    rgxnode *node;		/* nodes */
+    unsigned short nnodes;	/* # nodes */
+    char *classes;		/* character class bitmaps */
+    unsigned short nclasses;	/* # character classes */
+    unsigned short nsub;	/* # subexpressions */
+    int depth;			/* nesting depth */
+    char *err;			/* error message */
+} rgxparse;
+
+# define RI_CHAR	0	/* match character */
+# define RI_ANY		1	/* match any character */
+# define RI_CLASS	2	/* match character class */
+# define RI_BOL		3	/* assert start of string */
+# define RI_EOL		4	/* assert end of string */
+# define RI_SPLIT	5	/* continue at x, and with lower priority at y */
+# define RI_JMP		6	/* continue at x */
+# define RI_SAVE	7	/* save position in subexpression slot x */
+# define RI_MATCH	8	/* match found */
+
+typedef struct {
+    char op;			/* instruction */
+    unsigned short x;		/* character, class, slot or target */
+    unsigned short y;		/* alternative target */
+} rgxinst;
+
+# define RGX_DFASTATES	32	/* max # of states in a DFA */
+
+# define RS_BOL		0x01	/* state at start of string */
+# define RS_MATCH	0x02	/* a match ends here */
+# define RS_ENDMATCH	0x04	/* a match ends here, at the end of string */
+
+typedef struct {
+    unsigned short *pc;		/* instructions in this state */
+    unsigned short npc;		/* # instructions */
+    char flags;			/* state flags */
+    unsigned char trans[256];	/* transitions: state + 1, or 0 if unknown */
+} rgxstate;
+
+typedef struct {
+    bool search;		/* restart at every position */
+    bool failed;		/* too many states */
+    unsigned short nstates;	/* # states */
+    unsigned char start[2];	/* start states + 1, without and with BOL */
+    rgxstate *states;		/* states */
+} rgxdfa;
+
+struct _rgx_ {
+    unsigned short ninst;	/* # instructions */
+    unsigned short nsub;	/* # subexpressions, including the match */
+    rgxinst *inst;		/* program */
+    char *classes;		/* character class bitmaps */
+    rgxdfa search;		/* DFA to find a match */
+    rgxdfa match;		/* DFA to match the whole string */
+};
+
+# define CLASS(c, set, ch)	((c)[((set) << 5) + (UCHAR(ch) >> 3)] & \
+				 (1 << (UCHAR(ch) & 7)))
+
+/*
+ * NAME:	rgxparse->node()
+ * DESCRIPTION:	create a new node
+ */
+static unsigned short rp_node(rgxparse *rp, int type, unsigned int arg,
+	unsigned int sub)
+{
+    rgxnode *node;
+
+    node = &rp->node[rp->nnodes];
+    node->type = type;
+    node->lazy = FALSE;
+    node->arg = arg;
+    node->sub = sub;
+    node->next = RN_NONE;
+    return rp->nnodes++;
+}
+
+/*
+ * NAME:	rgxparse->class()
+ * DESCRIPTION:	parse a character class
+ */
+static unsigned short rp_class(rgxparse *rp)
+{
+    char *set, *first;
+    bool neg;
+    int c, h, i;
+
+    set = rp->classes + (rp->nclasses << 5);
+    memset(set, '\0', 32);
+    neg = FALSE;
+    if (rp->p < rp->end && *rp->p == '^') {
+	neg = TRUE;
+	rp->p++;
+    }
+    first = rp->p;
+    for (;;) {
+	if (rp->p == rp->end) {
+	    rp->err = "Unterminated character class";
+	    return RN_NONE;
+	}
+	c = UCHAR(*rp->p++);
+	if (c == ']' && rp->p - 1 != first) {
+	    break;	/* ] is taken literally if first in the set */
+	}
+	if (c == '\\') {
+	    if (rp->p == rp->end) {
+		rp->err = "Unterminated character class";
+		return RN_NONE;
+	    }
+	    c = UCHAR(*rp->p++);
+	}
+	h = c;
+	if (rp->end - rp->p >= 2 && rp->p[0] == '-' && rp->p[1] != ']') {
+	    rp->p++;
+	    h = UCHAR(*rp->p++);
+	    if (h == '\\') {
+		if (rp->p == rp->end) {
+		    rp->err = "Unterminated character class";
+		    return RN_NONE;
+		}
+		h = UCHAR(*rp->p++);
+	    }
+	    if (h < c) {
+		rp->err = "Bad range in character class";
+		return RN_NONE;
+	    }
+	}
+	for (i = c; i <= h; i++) {
+	    set[i >> 3] |= 1 << (i & 7);
+	}
+    }
+    if (neg) {
+	for (i = 0; i < 32; i++) {
+	    set[i] = ~set[i];
+	}
+    }
+
+    return rp_node(rp, RN_CLASS, rp->nclasses++, RN_NONE);
+}
+
+static unsigned short rp_alt (rgxparse*);
+
+/*
+ * NAME:	rgxparse->atom()
+ * DESCRIPTION:	parse an atom, possibly repeated
+ */
+static unsigned short rp_atom(rgxparse *rp)
+{
+    unsigned short n, sub;
+    int type;
+
+    switch (*rp->p++) {
+    case '(':
+	if (++rp->depth > RGX_MAXDEPTH) {
+	    rp->err = "Regular expression nested too deeply";
+	    return RN_NONE;
+	}
+	n = (rp->nsub < RGX_NSUB) ? rp->nsub++ : 0;
+	sub = rp_alt(rp);
+	if (rp->err != (char *) NULL) {
+	    return RN_NONE;
+	}
+	if (rp->p == rp->end || *rp->p != ')') {
+	    rp->err = "Unmatched ( in regular expression";
+	    return RN_NONE;
+	}
+	rp->p++;
+	--rp->depth;
+	n = rp_node(rp, RN_GROUP, n, sub);
+	break;
+
+    case ')':
+	rp->err = "Unmatched ) in regular expression";
+	return RN_NONE;
+
+    case '*':
+    case '+':
+    case '?':
+	rp->err = "Missing operand in regular expression";
+	return RN_NONE;
+
+    case '[':
+	n = rp_class(rp);
+	if (n == RN_NONE) {
+	    return RN_NONE;
+	}
+	break;
+
+    case '.':
+	n = rp_node(rp, RN_ANY, 0, RN_NONE);
+	break;
+
+    case '^':
+	n = rp_node(rp, RN_BOL, 0, RN_NONE);
+	break;
+
+    case '$':
+	n = rp_node(rp, RN_EOL, 0, RN_NONE);
+	break;
+
+    case '\\':
+	if (rp->p == rp->end) {
+	    rp->err = "Trailing \\ in regular expression";
+	    return RN_NONE;
+	}
+	rp->p++;
+	/* fall through */
+    default:
+	n = rp_node(rp, RN_CHAR, UCHAR(rp->p[-1]), RN_NONE);
+	break;
+    }
+
+    if (rp->p != rp->end) {
+	switch (*rp->p) {
+	case '*':
+	    type = RN_STAR;
+	    break;
+
+	case '+':
+	    type = RN_PLUS;
+	    break;
+
+	case '?':
+	    type = RN_QUEST;
+	    break;
+
+	default:
+	    return n;
+	}
+	rp->p++;
+	n = rp_node(rp, type, 0, n);
+	if (rp->p != rp->end && *rp->p == '?') {
+	    rp->node[n].lazy = TRUE;
+	    rp->p++;
+	}
+	if (rp->p != rp->end &&
+	    (*rp->p == '*' || *rp->p == '+' || *rp->p == '?')) {
+	    rp->err = "Nested repetition in regular expression";
+	    return RN_NONE;
+	}
+    }
+
+    return n;
+}
+
+/*
+ * NAME:	rgxparse->seq()
+ * DESCRIPTION:	parse a sequence of atoms
+ */
+static unsigned short rp_seq(rgxparse *rp)
+{
+    unsigned short first, last, n;
+
+    first = last = RN_NONE;
+    while (rp->p != rp->end && *rp->p != '|' && *rp->p != ')') {
+	n = rp_atom(rp);
+	if (n == RN_NONE) {
+	    return RN_NONE;
+	}
+	if (first == RN_NONE) {
+	    first = n;
+	} else {
+	    rp->node[last].next = n;
+	}
+	last = n;
+    }
+    return first;
+}
+
+/*
+ * NAME:	rgxparse->alt()
+ * DESCRIPTION:	parse alternatives
+ */
+static unsigned short rp_alt(rgxparse *rp)
+{
+    unsigned short seq, alt, last, n;
+
+    seq = rp_seq(rp);
+    if (rp->err != (char *) NULL || rp->p == rp->end || *rp->p != '|') {
+	return seq;
+    }
+
+    alt = rp_node(rp, RN_ALT, 0, last = rp_node(rp, RN_BRANCH, 0, seq));
+    do {
+	rp->p++;
+	seq = rp_seq(rp);
+	if (rp->err != (char *) NULL) {
+	    return RN_NONE;
+	}
+	n = rp_node(rp, RN_BRANCH, 0, seq);
+	rp->node[last].next = n;
+	last = n;
+    } while (rp->p != rp->end && *rp->p == '|');
+
+    return alt;
+}
+
+/*
+ * NAME:	rgx->emit()
+ * DESCRIPTION:	emit instructions for a sequence of nodes
+ */
+static unsigned short rgx_emit(rgxnode *node, unsigned short n, rgxinst *inst,
+	unsigned short pc)
+{
+    unsigned short start, split, jmp;
+    rgxnode *nd;
+
+    for (; n != RN_NONE; n = nd->next) {
+	nd = &node[n];
+	switch (nd->type) {
+	case RN_CHAR:
+	    inst[pc].op = RI_CHAR;
+	    inst[pc++].x = nd->arg;
+	    break;
+
+	case RN_ANY:
+	    inst[pc++].op = RI_ANY;
+	    break;
+
+	case RN_CLASS:
+	    inst[pc].op = RI_CLASS;
+	    inst[pc++].x = nd->arg;
+	    break;
+
+	case RN_BOL:
+	    inst[pc++].op = RI_BOL;
+	    break;
+
+	case RN_EOL:
+	    inst[pc++].op = RI_EOL;
+	    break;
+
+	case RN_GROUP:
+	    if (nd->arg != 0) {
+		inst[pc].op = RI_SAVE;
+		inst[pc++].x = nd->arg << 1;
+	    }
+	    pc = rgx_emit(node, nd->sub, inst, pc);
+	    if (nd->arg != 0) {
+		inst[pc].op = RI_SAVE;
+		inst[pc++].x = (nd->arg << 1) + 1;
+	    }
+	    break;
+
+	case RN_ALT:
+	    /*
+	     * split L1, L2; L1: a; jmp end; L2: split L3, L4; L3: b; ...
+	     */
+	    jmp = RN_NONE;
+	    for (n = nd->sub; n != RN_NONE; n = node[n].next) {
+		if (node[n].next != RN_NONE) {
+		    split = pc++;
+		    inst[split].op = RI_SPLIT;
+		    inst[split].x = pc;
+		    pc = rgx_emit(node, node[n].sub, inst, pc);
+		    inst[pc].op = RI_JMP;
+		    inst[pc].x = jmp;		/* chain of jumps to patch */
+		    jmp = pc++;
+		    inst[split].y = pc;
+		} else {
+		    pc = rgx_emit(node, node[n].sub, inst, pc);
+		}
+	    }
+	    while (jmp != RN_NONE) {
+		n = inst[jmp].x;
+		inst[jmp].x = pc;
+		jmp = n;
+	    }
+	    break;
+
+	case RN_STAR:
+	    /*
+	     * L1: split L2, L3; L2: a; jmp L1; L3:
+	     */
+	    split = pc++;
+	    pc = rgx_emit(node, nd->sub, inst, pc);
+	    inst[pc].op = RI_JMP;
+	    inst[pc++].x = split;
+	    inst[split].op = RI_SPLIT;
+	    if (nd->lazy) {
+		inst[split].x = pc;
+		inst[split].y = split + 1;
+	    } else {
+		inst[split].x = split + 1;
+		inst[split].y = pc;
+	    }
+	    break;
+
+	case RN_PLUS:
+	    /*
+	     * L1: a; split L1, L2; L2:
+	     */
+	    start = pc;
+	    pc = rgx_emit(node, nd->sub, inst, pc);
+	    inst[pc].op = RI_SPLIT;
+	    if (nd->lazy) {
+		inst[pc].x = pc + 1;
+		inst[pc].y = start;
+	    } else {
+		inst[pc].x = start;
+		inst[pc].y = pc + 1;
+	    }
+	    pc++;
+	    break;
+
+	case RN_QUEST:
+	    /*
+	     * split L1, L2; L1: a; L2:
+	     */
+	    split = pc++;
+	    pc = rgx_emit(node, nd->sub, inst, pc);
+	    inst[split].op = RI_SPLIT;
+	    if (nd->lazy) {
+		inst[split].x = pc;
+		inst[split].y = split + 1;
+	    } else {
+		inst[split].x = split + 1;
+		inst[split].y = pc;
+	    }
+	    break;
+	}
+    }
+
+    return pc;
+}
+
+/*
+ * NAME:	rgx->new()
+ * DESCRIPTION:	compile a regular expression
+ */
+rgx *rgx_new(char *pattern, unsigned int len)
+{
+    rgxparse rp;
+    unsigned short seq, ninst;
+    rgxinst *inst;
+    rgx *rx;
+
+    if (len > RGX_MAXLEN) {
+	error("Regular expression too large");
+    }
+
+    rp.p = pattern;
+    rp.end = pattern + len;
+    rp.node = ALLOC(rgxnode, 2 * len + 1);
+    rp.nnodes = 0;
+    rp.classes = ALLOC(char, (len / 2 + 1) << 5);
+    rp.nclasses = 0;
+    rp.nsub = 1;
+    rp.depth = 0;
+    rp.err = (char *) NULL;
+
+    seq = rp_alt(&rp);
+    if (rp.err == (char *) NULL && rp.p != rp.end) {
+	rp.err = "Unmatched ) in regular expression";
+    }
+    if (rp.err != (char *) NULL) {
+	FREE(rp.classes);
+	FREE(rp.node);
+	error(rp.err);
+    }
+
+    /* save 0; ...; save 1; match */
+    inst = ALLOCA(rgxinst, 2 * rp.nnodes + 3);
+    inst[0].op = RI_SAVE;
+    inst[0].x = 0;
+    ninst = rgx_emit(rp.node, seq, inst, 1);
+    inst[ninst].op = RI_SAVE;
+    inst[ninst++].x = 1;
+    inst[ninst++].op = RI_MATCH;
+    FREE(rp.node);
+
+    rx = ALLOC(rgx, 1);
+    rx->ninst = ninst;
+    rx->nsub = rp.nsub;
+    rx->inst = ALLOC(rgxinst, ninst);
+    memcpy(rx->inst, inst, ninst * sizeof(rgxinst));
+    AFREE(inst);
+    if (rp.nclasses != 0) {
+	rx->classes = ALLOC(char, rp.nclasses << 5);
+	memcpy(rx->classes, rp.classes, rp.nclasses << 5);
+    } else {
+	rx->classes = (char *) NULL;
+    }
+    FREE(rp.classes);
+
+    rx->search.search = TRUE;
+    rx->match.search = FALSE;
+    rx->search.failed = rx->match.failed = FALSE;
+    rx->search.nstates = rx->match.nstates = 0;
+    rx->search.start[0] = rx->search.start[1] = 0;
+    rx->match.start[0] = rx->match.start[1] = 0;
+    rx->search.states = rx->match.states = (rgxstate *) NULL;
+
+    return rx;
+}
+
+/*
+ * NAME:	rgxdfa->clear()
+ * DESCRIPTION:	remove the states of a DFA
+ */
+static void rd_clear(rgxdfa *fa)
+{
+    unsigned short i;
+
+    if (fa->states != (rgxstate *) NULL) {
+	for (i = 0; i < fa->nstates; i++) {
+	    if (fa->states[i].pc != (unsigned short *) NULL) {
+		FREE(fa->states[i].pc);
+	    }
+	}
+	FREE(fa->states);
+    }
+}
+
+/*
+ * NAME:	rgx->del()
+ * DESCRIPTION:	delete a compiled regular expression
+ */
+void rgx_del(rgx *rx)
+{
+    rd_clear(&rx->search);
+    rd_clear(&rx->match);
+    FREE(rx->inst);
+    if (rx->classes != (char *) NULL) {
+	FREE(rx->classes);
+    }
+    FREE(rx);
+}
+
+/*
+ * NAME:	rgx->nsub()
+ * DESCRIPTION:	return the number of subexpressions, including the match
+ */
+unsigned short rgx_nsub(rgx *rx)
+{
+    return rx->nsub;
+}
+
+/*
+ * NAME:	rgx->closure()
+ * DESCRIPTION:	compute the set of instructions reachable without consuming
+ *		characters, returning its size
+ */
+static unsigned short rgx_closure(rgx *rx, unsigned short *seeds,
+	unsigned short nseeds, bool bol, bool eol, unsigned short *set, char *mark)
+{
+    unsigned short *stack, *visit;
+    unsigned short sp, nvisit, nset, pc;
+    rgxinst *inst;
+
+    stack = ALLOCA(unsigned short, 3 * rx->ninst + 1);
+    visit = ALLOCA(unsigned short, rx->ninst);
+    sp = nvisit = nset = 0;
+    while (nseeds != 0) {
+	stack[sp++] = seeds[--nseeds];
+    }
+
+    while (sp != 0) {
+	pc = stack[--sp];
+	if (mark[pc]) {
+	    continue;
+	}
+	mark[pc] = TRUE;
+	visit[nvisit++] = pc;
+	inst = &rx->inst[pc];
+	switch (inst->op) {
+	case RI_SPLIT:
+	    stack[sp++] = inst->y;
+	    stack[sp++] = inst->x;
+	    break;
+
+	case RI_JMP:
+	    stack[sp++] = inst->x;
+	    break;
+
+	case RI_SAVE:
+	    stack[sp++] = pc + 1;
+	    break;
+
+	case RI_BOL:
+	    if (bol) {
+		stack[sp++] = pc + 1;
+	    }
+	    break;
+
+	case RI_EOL:
+	    if (eol) {
+		stack[sp++] = pc + 1;
+	    } else {
+		set[nset++] = pc;
+	    }
+	    break;
+
+	default:
+	    set[nset++] = pc;
+	    break;
+	}
+    }
+
+    while (nvisit != 0) {
+	mark[visit[--nvisit]] = FALSE;
+    }
+    AFREE(visit);
+    AFREE(stack);
+
+    return nset;
+}
+
+/*
+ * NAME:	rgx->cmp()
+ * DESCRIPTION:	compare two instruction numbers
+ */
+static int rgx_cmp(cvoid *pc1, cvoid *pc2)
+{
+    return *(unsigned short *) pc1 - *(unsigned short *) pc2;
+}
+
+/*
+ * NAME:	rgxdfa->state()
+ * DESCRIPTION:	find or create the state for a set of seed instructions,
+ *		returning the state + 1, or 0 if there are too many states
+ */
+static unsigned char rd_state(rgx *rx, rgxdfa *fa, unsigned short *seeds,
+	unsigned short nseeds, bool bol)
+{
+    unsigned short *set, *eset;
+    unsigned short nset, neset, i;
+    char *mark;
+    char flags;
+    rgxstate *state;
+
+    mark = ALLOCA(char, rx->ninst);
+    memset(mark, '\0', rx->ninst);
+    set = ALLOCA(unsigned short, rx->ninst);
+    nset = rgx_closure(rx, seeds, nseeds, bol, FALSE, set, mark);
+    qsort(set, nset, sizeof(unsigned short), rgx_cmp);
+
+    flags = (bol) ? RS_BOL : 0;
+    for (i = 0; i < nset; i++) {
+	if (rx->inst[set[i]].op == RI_MATCH) {
+	    flags |= RS_MATCH | RS_ENDMATCH;
+	    break;
+	}
+    }
+    if (!(flags & RS_MATCH)) {
+	/* see if a match can be reached at the end of the string */
+	eset = ALLOCA(unsigned short, rx->ninst);
+	for (i = neset = 0; i < nset; i++) {
+	    if (rx->inst[set[i]].op == RI_EOL) {
+		eset[neset++] = set[i] + 1;
+	    }
+	}
+	if (neset != 0) {
+	    neset = rgx_closure(rx, eset, neset, bol, TRUE, eset, mark);
+	    for (i = 0; i < neset; i++) {
+		if (rx->inst[eset[i]].op == RI_MATCH) {
+		    flags |= RS_ENDMATCH;
+		    break;
+		}
+	    }
+	}
+	AFREE(eset);
+    }
+    AFREE(mark);
+
+    /* look for an existing state */
+    for (i = 0, state = fa->states; i < fa->nstates; i++, state++) {
+	if (state->flags == flags && state->npc == nset &&
+	    memcmp(state->pc, set, nset * sizeof(unsigned short)) == 0) {
+	    AFREE(set);
+	    return i + 1;
+	}
+    }
+
+    if (fa->nstates == RGX_DFASTATES) {
+	/* the DFA would become too large */
+	AFREE(set);
+	fa->failed = TRUE;
+	return 0;
+    }
+    if (fa->states == (rgxstate *) NULL) {
+	fa->states = ALLOC(rgxstate, RGX_DFASTATES);
+    }
+    state = &fa->states[fa->nstates];
+    state->npc = nset;
+    if (nset != 0) {
+	state->pc = ALLOC(unsigned short, nset);
+	memcpy(state->pc, set, nset * sizeof(unsigned short));
+    } else {
+	state->pc = (unsigned short *) NULL;
+    }
+    state->flags = flags;
+    memset(state->trans, '\0', 256);
+    AFREE(set);
+
+    return ++fa->nstates;
+}
+
+/*
+ * NAME:	rgxdfa->trans()
+ * DESCRIPTION:	compute a transition, returning the new state + 1, or 0 if
+ *		there are too many states
+ */
+static unsigned char rd_trans(rgx *rx, rgxdfa *fa, unsigned short s, int c)
+{
+    unsigned short *seeds;
+    unsigned short nseeds, i;
+    rgxstate *state;
+    rgxinst *inst;
+    unsigned char t;
+
+    seeds = ALLOCA(unsigned short, rx->ninst + 1);
+    state = &fa->states[s];
+    for (i = nseeds = 0; i < state->npc; i++) {
+	inst = &rx->inst[state->pc[i]];
+	switch (inst->op) {
+	case RI_CHAR:
+	    if (inst->x != c) {
+		continue;
+	    }
+	    break;
+
+	case RI_ANY:
+	    break;
+
+	case RI_CLASS:
+	    if (!CLASS(rx->classes, inst->x, c)) {
+		continue;
+	    }
+	    break;
+
+	default:
+	    continue;
+	}
+	seeds[nseeds++] = state->pc[i] + 1;
+    }
+    if (fa->search) {
+	seeds[nseeds++] = 0;	/* a match may start at the next position */
+    }
+
+    t = rd_state(rx, fa, seeds, nseeds, FALSE);
+    AFREE(seeds);
+    if (t != 0) {
+	fa->states[s].trans[c] = t;
+    }
+    return t;
+}
+
+/*
+ * NAME:	rgxdfa->run()
+ * DESCRIPTION:	run a DFA, returning 1 for a match, 0 for no match, or -1
+ *		if the DFA has become too large
+ */
+static int rd_run(rgx *rx, rgxdfa *fa, char *text, ssizet len, ssizet start,
+	Uint *ticks)
+{
+    unsigned short seed;
+    unsigned char s, t;
+    rgxstate *state;
+    char *p, *end;
+
+    if (fa->failed) {
+	return -1;
+    }
+    if (fa->start[start == 0] == 0) {
+	seed = 0;
+	fa->start[start == 0] = rd_state(rx, fa, &seed, 1, (start == 0));
+	if (fa->start[start == 0] == 0) {
+	    return -1;
+	}
+    }
+    s = fa->start[start == 0] - 1;
+
+    for (p = text + start, end = text + len; p != end; p++) {
+	state = &fa->states[s];
+	if (state->npc == 0 || (fa->search && (state->flags & RS_MATCH))) {
+	    break;
+	}
+	t = state->trans[UCHAR(*p)];
+	if (t == 0) {
+	    t = rd_trans(rx, fa, s, UCHAR(*p));
+	    if (t == 0) {
+		return -1;
+	    }
+	}
+	s = t - 1;
+    }
+    *ticks += (p - (text + start) + 3) >> 2;
+
+    state = &fa->states[s];
+    if (p == end) {
+	return ((state->flags & RS_ENDMATCH) != 0);
+    }
+    return ((state->flags & RS_MATCH) != 0);
+}
+
+typedef struct {
+    rgx *rx;			/* regular expression */
+    char *text;			/* string */
+    ssizet len;			/* length of string */
+    Uint gen;			/* current generation */
+    Uint *mark;			/* generation in which instruction was added */
+    unsigned short nsub2;	/* # subexpression slots */
+} rgxvm;
+
+typedef struct {
+    unsigned short n;		/* # threads */
+    unsigned short *pc;		/* thread instructions */
+    Int *sub;			/* thread subexpression slots */
+} rgxlist;
+
+/*
+ * NAME:	rgxvm->add()
+ * DESCRIPTION:	add a thread to a list, following instructions which do not
+ *		consume characters
+ */
+static void rv_add(rgxvm *vm, rgxlist *list, unsigned short pc, Int *sub,
+	ssizet pos)
+{
+    rgxinst *inst;
+    Int save;
+
+    if (vm->mark[pc] == vm->gen) {
+	return;
+    }
+    vm->mark[pc] = vm->gen;
+
+    inst = &vm->rx->inst[pc];
+    switch (inst->op) {
+    case RI_JMP:
+	rv_add(vm, list, inst->x, sub, pos);
+	break;
+
+    case RI_SPLIT:
+	rv_add(vm, list, inst->x, sub, pos);
+	rv_add(vm, list, inst->y, sub, pos);
+	break;
+
+    case RI_SAVE:
+	if (inst->x < vm->nsub2) {
+	    save = sub[inst->x];
+	    sub[inst->x] = pos;
+	    rv_add(vm, list, pc + 1, sub, pos);
+	    sub[inst->x] = save;
+	} else {
+	    rv_add(vm, list, pc + 1, sub, pos);
+	}
+	break;
+
+    case RI_BOL:
+	if (pos == 0) {
+	    rv_add(vm, list, pc + 1, sub, pos);
+	}
+	break;
+
+    case RI_EOL:
+	if (pos == vm->len) {
+	    rv_add(vm, list, pc + 1, sub, pos);
+	}
+	break;
+
+    default:
+	list->pc[list->n] = pc;
+	memcpy(list->sub + list->n * vm->nsub2, sub, vm->nsub2 * sizeof(Int));
+	list->n++;
+	break;
+    }
+}
+
+/*
+ * NAME:	rgxvm->run()
+ * DESCRIPTION:	simulate the NFA, finding the preferred match and its
+ *		subexpressions
+ */
+static bool rv_run(rgx *rx, char *text, ssizet len, ssizet start, bool whole,
+	Int *sub, Uint *ticks)
+{
+    rgxvm vm;
+    rgxlist list[2], *clist, *nlist, *tmp;
+    Int *init;
+    ssizet pos;
+    unsigned short i;
+    rgxinst *inst;
+    bool matched;
+    int c;
+
+    vm.rx = rx;
+    vm.text = text;
+    vm.len = len;
+    vm.gen = 0;
+    vm.mark = ALLOC(Uint, rx->ninst);
+    memset(vm.mark, '\xff', rx->ninst * sizeof(Uint));
+    vm.nsub2 = rx->nsub << 1;
+    for (i = 0; i < 2; i++) {
+	list[i].n = 0;
+	list[i].pc = ALLOC(unsigned short, rx->ninst);
+	list[i].sub = ALLOC(Int, rx->ninst * vm.nsub2);
+    }
+    init = ALLOCA(Int, vm.nsub2);
+    for (i = 0; i < vm.nsub2; i++) {
+	init[i] = -1;
+    }
+    clist = &list[0];
+    nlist = &list[1];
+    matched = FALSE;
+
+    for (pos = start; ; pos++) {
+	if (!matched && (pos == start || !whole)) {
+	    /* a new thread with the lowest priority */
+	    rv_add(&vm, clist, 0, init, pos);
+	}
+	if (clist->n == 0 && (whole || matched || pos == len)) {
+	    /* no thread left, and no new thread will be started */
+	    break;
+	}
+
+	c = (pos < len) ? UCHAR(text[pos]) : -1;
+	vm.gen++;
+	for (i = 0; i < clist->n; i++) {
+	    inst = &rx->inst[clist->pc[i]];
+	    switch (inst->op) {
+	    case RI_CHAR:
+		if (inst->x != c) {
+		    continue;
+		}
+		break;
+
+	    case RI_ANY:
+		if (c < 0) {
+		    continue;
+		}
+		break;
+
+	    case RI_CLASS:
+		if (c < 0 || !CLASS(rx->classes, inst->x, c)) {
+		    continue;
+		}
+		break;
+
+	    case RI_MATCH:
+		if (whole && pos != len) {
+		    continue;
+		}
+		memcpy(sub, clist->sub + i * vm.nsub2, vm.nsub2 * sizeof(Int));
+		matched = TRUE;
+		i = clist->n;	/* cut off threads with lower priority */
+		continue;
+
+	    default:
+		continue;
+	    }
+	    rv_add(&vm, nlist, clist->pc[i] + 1, clist->sub + i * vm.nsub2,
+		   pos + 1);
+	}
+
+	if (pos == len) {
+	    break;
+	}
+	tmp = clist;
+	clist = nlist;
+	nlist = tmp;
+	nlist->n = 0;
+    }
+    *ticks += pos - start + 1;
+
+    AFREE(init);
+    for (i = 0; i < 2; i++) {
+	FREE(list[i].sub);
+	FREE(list[i].pc);
+    }
+    FREE(vm.mark);
+
+    return matched;
+}
+
+/*
+ * NAME:	rgx->search()
+ * DESCRIPTION:	search for a match starting at or after the given offset,
+ *		or if whole is TRUE, match the whole string; if sub is
+ *		non-NULL, store the positions of the subexpressions in it
+ */
+bool rgx_search(rgx *rx, char *text, ssizet len, ssizet start, bool whole,
+	Int *sub, Uint *ticks)
+{
+    int result;
+    Int buf[RGX_NSUB << 1];
+
+    result = rd_run(rx, (whole) ? &rx->match : &rx->search, text, len,
+		    start, ticks);
+    if (result == 0) {
+	return FALSE;
+    }
+    if (result > 0 && sub == (Int *) NULL) {
+	return TRUE;
+    }
+
+    return rv_run(rx, text, len, start, whole,
+		  (sub != (Int *) NULL) ? sub : buf, ticks);
+}
@@ -0,0 +1,28 @@
+/*
+ * This file is part of DGD, https://github.com/dworkin/dgd
+ * Copyright (C) 1993-2010 Dworkin B.V.
+ * Copyright (C) 2010 DGD Authors (see the commit log for details)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+typedef struct _rgx_ rgx;
+
+# define RGX_NSUB	10	/* max # of subexpressions, including match */
+
+extern rgx     *rgx_new		(char*, unsigned int);
+extern void	rgx_del		(rgx*);
+extern unsigned short rgx_nsub	(rgx*);
+extern bool	rgx_search	(rgx*, char*, ssizet, ssizet, bool, Int*,
+				   Uint*);
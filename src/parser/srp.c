@@ -1092,6 +1092,38 @@ static srpstate *srp_expand(srp *lr, srpstate *state)
     return state;
 }
 
+/*
+ * NAME:	srp->build()
+ * DESCRIPTION:	expand all states, one tick per state, until ticks run out;
+ *		return FALSE if the shift/reduce parser has become too big
+ */
+bool srp_build(srp *lr, Int *ticks, unsigned short *nstates, Uint *size)
+{
+    srpstate *state;
+
+    for (state = lr->states; lr->nstates != lr->nexpanded; state++) {
+	if (lr->nstates > SHRT_MAX ||
+	    lr->srpsize > (Uint) MAX_AUTOMSZ * USHRT_MAX) {
+	    return FALSE;
+	}
+	if (state->nred < 0) {
+	    if (*ticks < 0) {
+		break;	/* continue later */
+	    }
+	    state = srp_expand(lr, state);
+	    --*ticks;
+	}
+    }
+    if (lr->nstates > SHRT_MAX ||
+	lr->srpsize > (Uint) MAX_AUTOMSZ * USHRT_MAX) {
+	return FALSE;
+    }
+
+    *nstates = lr->nstates;
+    *size = lr->srpsize;
+    return TRUE;
+}
+
 /*
  * NAME:	srp->check()
  * DESCRIPTION:	fetch reductions for a given state, possibly first expanding it
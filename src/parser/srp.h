@@ -23,6 +23,7 @@ extern srp     *srp_new		(char*);
 extern void	srp_del		(srp*);
 extern srp     *srp_load	(char*, char*, Uint);
 extern bool	srp_save	(srp*, char**, Uint*);
+extern bool	srp_build	(srp*, Int*, unsigned short*, Uint*);
 extern short	srp_check	(srp*, unsigned int, unsigned short*,
 				   char**);
 extern short	srp_shift	(srp*, unsigned int, unsigned int);
@@ -298,6 +298,10 @@ typedef struct {
 static control *chead, *ctail;		/* list of control blocks */
 static dataspace *dhead, *dtail;	/* list of dataspace blocks */
 static dataspace *gcdata;		/* next dataspace to garbage collect */
+static gcinfo gcstat;			/* statistics of last lap */
+static gcinfo gccur;			/* statistics of current lap */
+static Uuint gctime;			/* time spent in current lap */
+static sector gcvisits;			/* # dataspaces visited in this lap */
 static sector nctrl;			/* # control blocks */
 static sector ndata;			/* # dataspace blocks */
 static bool conv_ctrl1, conv_ctrl2;	/* convert control blocks? */
@@ -319,6 +323,10 @@ void d_init()
     chead = ctail = (control *) NULL;
     dhead = dtail = (dataspace *) NULL;
     gcdata = (dataspace *) NULL;
+    memset(&gcstat, '\0', sizeof(gcinfo));
+    memset(&gccur, '\0', sizeof(gcinfo));
+    gctime = 0;
+    gcvisits = 0;
     nctrl = ndata = 0;
     conv_ctrl1 = conv_ctrl2 = conv_data = conv_co1 = conv_co2 = conv_type =
 		 conv_time = conv_vm = FALSE;
@@ -484,6 +492,15 @@ static dataspace *d_alloc_dataspace(object *obj)
     /* parse_string data */
     data->parser = (struct _parser_ *) NULL;
 
+    /* garbage collection */
+    data->gcage = 0;
+    data->gclap = gcstat.laps;
+
+    /* memory accounting */
+    data->strbytes = 0;
+    data->arrbytes = 0;
+    data->swapsize = 0;
+
     return data;
 }
 
@@ -642,6 +659,50 @@ control *d_load_control(object *obj)
     return ctrl;
 }
 
+/*
+ * NAME:	data_strsize()
+ * DESCRIPTION:	get the size of the string text of a dataspace in memory,
+ *		from the header of compressed text if needed
+ */
+static Uint data_strsize(sdataspace *header, sector *sectors,
+			 void (*readv) (char*, sector*, Uint, Uint))
+{
+    char buf[4];
+
+    if (!(header->flags & DATA_STRCMP) || header->strsize == 0) {
+	return header->strsize;
+    }
+    (*readv)(buf, sectors, (Uint) 4,
+	     sizeof(sdataspace) + header->nsectors * (Uint) sizeof(sector) +
+	     header->nvariables * (Uint) sizeof(svalue) +
+	     header->narrays * (Uint) sizeof(sarray) +
+	     header->eltsize * (Uint) sizeof(svalue) +
+	     header->nstrings * (Uint) sizeof(sstring));
+    return (UCHAR(buf[0]) << 24) | (UCHAR(buf[1]) << 16) |
+	   (UCHAR(buf[2]) << 8) | UCHAR(buf[3]);
+}
+
+/*
+ * NAME:	data_usage()
+ * DESCRIPTION:	compute memory and swap usage from a dataspace header, with
+ *		the given size of string text in memory
+ */
+static void data_usage(sdataspace *header, Uint strsize, long *strbytes,
+		       long *arrbytes, Uint *swapsize)
+{
+    *strbytes = header->nstrings * (long) sizeof(string) + strsize;
+    *arrbytes = header->narrays * (long) sizeof(array) +
+		header->eltsize * (long) sizeof(value);
+    *swapsize = sizeof(sdataspace) +
+		header->nsectors * (Uint) sizeof(sector) +
+		header->nvariables * (Uint) sizeof(svalue) +
+		header->narrays * (Uint) sizeof(sarray) +
+		header->eltsize * (Uint) sizeof(svalue) +
+		header->nstrings * (Uint) sizeof(sstring) +
+		header->strsize +
+		header->ncallouts * (Uint) sizeof(scallout);
+}
+
 /*
  * NAME:	load_dataspace()
  * DESCRIPTION:	load the dataspace header block
@@ -694,6 +755,10 @@ static dataspace *load_dataspace(object *obj, void (*readv) (char*, sector*, Uin
     data->ncallouts = header.ncallouts;
     data->fcallouts = header.fcallouts;
 
+    /* memory accounting */
+    data_usage(&header, data_strsize(&header, data->sectors, readv),
+	       &data->strbytes, &data->arrbytes, &data->swapsize);
+
     return data;
 }
 
@@ -715,6 +780,36 @@ dataspace *d_load_dataspace(object *obj)
     return data;
 }
 
+/*
+ * NAME:	data->get_datasize()
+ * DESCRIPTION:	get the memory and swap usage of a dataspace from its header
+ *		in swap, without loading the dataspace
+ */
+void d_get_datasize(object *obj, long *strbytes, long *arrbytes,
+		    Uint *swapsize)
+{
+    sdataspace header;
+    sector *sectors;
+    Uint size;
+
+    sw_readv((char *) &header, &obj->dfirst, (Uint) sizeof(sdataspace),
+	     (Uint) 0);
+    if (!(header.flags & DATA_STRCMP) || header.strsize == 0) {
+	data_usage(&header, header.strsize, strbytes, arrbytes, swapsize);
+    } else {
+	/* the text size is in front of the compressed text */
+	sectors = ALLOC(sector, header.nsectors);
+	sectors[0] = obj->dfirst;
+	size = header.nsectors * (Uint) sizeof(sector);
+	if (header.nsectors > 1) {
+	    sw_readv((char *) sectors, sectors, size, (Uint) sizeof(sdataspace));
+	}
+	data_usage(&header, data_strsize(&header, sectors, sw_readv), strbytes,
+		   arrbytes, swapsize);
+	FREE(sectors);
+    }
+}
+
 /*
  * NAME:	data->ref_control()
  * DESCRIPTION:	reference control block
@@ -2391,6 +2486,8 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 		sw_writev((char *) data->scallouts, data->sectors,
 			  header.ncallouts * (Uint) sizeof(scallout), size);
 	    }
+	    data->swapsize = size +
+			     header.ncallouts * (Uint) sizeof(scallout);
 	}
 
 	d_free_values(data);
@@ -2401,6 +2498,12 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	data->nstrings = header.nstrings;
 	data->strsize = save.strsize;
 
+	/* exact memory usage */
+	data->strbytes = header.nstrings * (long) sizeof(string) +
+			 save.strsize;
+	data->arrbytes = header.narrays * (long) sizeof(array) +
+			 header.eltsize * (long) sizeof(value);
+
 	data->base.schange = 0;
 	data->base.achange = 0;
     }
@@ -2414,6 +2517,33 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 }
 
 
+# define GC_OLDAGE	4	/* # laps after which a dataspace is old */
+# define GC_OLDLAPS	8	/* collect old dataspaces every # laps */
+# define GC_LARGE	1024	/* # array elements in a large dataspace */
+
+/*
+ * NAME:	data->gc_defer()
+ * DESCRIPTION:	Determine whether collecting a dataspace can be deferred.
+ *		Only old, large dataspaces which would have to be rescanned
+ *		in full are deferred; if only variables or array elements
+ *		changed, just the dirty values are saved, which is cheap.
+ */
+static bool d_gc_defer(dataspace *data, bool swap)
+{
+    if (data->gcage < GC_OLDAGE ||
+	data->narrays + data->eltsize < GC_LARGE ||
+	gcstat.laps - data->gclap >= GC_OLDLAPS) {
+	return FALSE;
+    }
+    if (swap && (data->base.flags & MOD_SAVE)) {
+	return TRUE;
+    }
+    return ((data->base.flags & MOD_ALL) &&
+	    (data->svariables == (svalue *) NULL ||
+	     data->base.achange != 0 || data->base.schange != 0 ||
+	     (data->base.flags & MOD_NEWCALLOUT)));
+}
+
 /*
  * NAME:	data->swapout()
  * DESCRIPTION:	Swap out a portion of the control and dataspace blocks in
@@ -2463,15 +2593,48 @@ sector d_swapout(unsigned int frag)
 
     /* perform garbage collection for one dataspace */
     if (gcdata != (dataspace *) NULL) {
-	if (d_save_dataspace(gcdata, (frag != 0)) && frag != 0) {
-	    count++;
+	Uuint time;
+
+	time = P_utime();
+	data = gcdata;
+	gcdata = data->gcnext;
+	if (d_gc_defer(data, (frag != 0))) {
+	    gccur.ndeferred++;
+	} else {
+	    if (d_save_dataspace(data, (frag != 0)) && frag != 0) {
+		count++;
+	    }
+	    data->gclap = gcstat.laps;
+	    gccur.ncollected++;
+	}
+	if (data->gcage != USHRT_MAX) {
+	    data->gcage++;
+	}
+	gctime += P_utime() - time;
+
+	if (++gcvisits >= ndata) {
+	    /* lap completed */
+	    gccur.laps = gcstat.laps + 1;
+	    gccur.time = (gctime > 0xffffffffL) ? 0xffffffffL : (Uint) gctime;
+	    gcstat = gccur;
+	    gccur.ncollected = gccur.ndeferred = 0;
+	    gctime = 0;
+	    gcvisits = 0;
 	}
-	gcdata = gcdata->gcnext;
     }
 
     return count;
 }
 
+/*
+ * NAME:	data->gcinfo()
+ * DESCRIPTION:	return garbage collection statistics of the last lap
+ */
+gcinfo *d_gcinfo()
+{
+    return &gcstat;
+}
+
 /*
  * NAME:	data->upgrade_mem()
  * DESCRIPTION:	upgrade all obj and all objects cloned from obj that have
@@ -0,0 +1,83 @@
+/*
+ * Regression tests for the regexp kfuns.  Compile this object in any
+ * mudlib and call run(); it returns nil if all tests pass, or a
+ * description of the first failure.
+ */
+
+/*
+ * NAME:	show()
+ * DESCRIPTION:	describe the result of regexp_search()
+ */
+static string show(int *a)
+{
+    string str;
+    int i;
+
+    if (!a) {
+	return "nil";
+    }
+    str = "({";
+    for (i = 0; i < sizeof(a); i++) {
+	str += " " + a[i];
+    }
+    return str + " })";
+}
+
+/*
+ * NAME:	search()
+ * DESCRIPTION:	check the outcome of a search
+ */
+static string search(string str, string rgx, int *result)
+{
+    int *a;
+    int i, same;
+
+    a = regexp_search(str, rgx);
+    same = (a == nil) == (result == nil);
+    if (same && a) {
+	same = (sizeof(a) == sizeof(result));
+	for (i = 0; same && i < sizeof(a); i++) {
+	    same = (a[i] == result[i]);
+	}
+    }
+    if (!same) {
+	return "regexp_search(\"" + str + "\", \"" + rgx + "\") returned " +
+	       show(a) + ", expected " + show(result);
+    }
+    return nil;
+}
+
+/*
+ * NAME:	run()
+ * DESCRIPTION:	run all tests
+ */
+string run()
+{
+    string err;
+
+    /* anchors that fail at the start can still match later on */
+    if ((err=search("bc", "$", ({ 2, 1 }))) ||
+	(err=search("bc", "^a|$", ({ 2, 1 }))) ||
+	(err=search("bc", "^b|$", ({ 0, 0 }))) ||
+	(err=search("abc", "$|c", ({ 2, 2 }))) ||
+	(err=search("abc", "^c|c$", ({ 2, 2 }))) ||
+	(err=search("abc", "^x", nil)) ||
+	(err=search("abc", "x$", nil))) {
+	return err;
+    }
+
+    /* empty matches in alternatives */
+    if ((err=search("bc", "a|", ({ 0, -1 }))) ||
+	(err=search("bc", "x*|b", ({ 0, -1 }))) ||
+	(err=search("bc", "(x|)c", ({ 1, 1, 1, 0 }))) ||
+	(err=search("", "a|$", ({ 0, -1 })))) {
+	return err;
+    }
+
+    /* whole string matches */
+    if (!regexp_match("bc", "b(x|)c") || regexp_match("bc", "^a|$")) {
+	return "regexp_match() failed";
+    }
+
+    return nil;
+}